@@ -0,0 +1,205 @@
+"""
+pyperf benchmarks for the retracesoftware.functional combinators.
+
+Each case is timed for the native extension, the pure-Python fallback and a
+hand-written/functools reference, so both per-call cost and the native
+speed-up are visible:
+
+    python benchmarks/bench_functional.py -o results.json
+    python -m pyperf compare_to old.json results.json --table
+
+Use `--variant` to restrict which implementations run and pyperf's
+`--bench` (repeatable) to pick cases, e.g. `--bench 'partial[native]'`.
+"""
+
+from __future__ import annotations
+
+import functools
+import operator
+import threading
+
+import pyperf
+
+import retracesoftware.functional as fn
+from retracesoftware.functional import _pure
+
+INNER_LOOPS = 20
+
+VARIANTS = ("native", "pure", "reference")
+
+
+def _call0(loops, func):
+    it = range(loops)
+    t0 = pyperf.perf_counter()
+    for _ in it:
+        func(); func(); func(); func(); func(); func(); func(); func(); func(); func()
+        func(); func(); func(); func(); func(); func(); func(); func(); func(); func()
+    return pyperf.perf_counter() - t0
+
+
+def _call1(loops, func, a):
+    it = range(loops)
+    t0 = pyperf.perf_counter()
+    for _ in it:
+        func(a); func(a); func(a); func(a); func(a); func(a); func(a); func(a); func(a); func(a)
+        func(a); func(a); func(a); func(a); func(a); func(a); func(a); func(a); func(a); func(a)
+    return pyperf.perf_counter() - t0
+
+
+def _call2(loops, func, a, b):
+    it = range(loops)
+    t0 = pyperf.perf_counter()
+    for _ in it:
+        func(a, b); func(a, b); func(a, b); func(a, b); func(a, b)
+        func(a, b); func(a, b); func(a, b); func(a, b); func(a, b)
+        func(a, b); func(a, b); func(a, b); func(a, b); func(a, b)
+        func(a, b); func(a, b); func(a, b); func(a, b); func(a, b)
+    return pyperf.perf_counter() - t0
+
+
+_CALLERS = {0: _call0, 1: _call1, 2: _call2}
+
+
+def _is_int(x):
+    return type(x) is int
+
+
+def _is_str(x):
+    return type(x) is str
+
+
+def _is_not_none(x):
+    return x is not None
+
+
+_NESTED = {"a": [1, 2, (3, 4)], "b": ({"c": 5}, [6, [7, 8]]), "d": 9}
+_KEY = object()
+
+
+def _cases(impl):
+    """(name, factory, args) for every case, built with `impl` (the native
+    module or _pure) so the same construction is timed for both."""
+
+    def memo():
+        m = impl.memoize_one_arg(id)
+        m(_KEY)
+        return m
+
+    def cache():
+        c = impl.Cache(id)
+        c(_KEY)
+        return c
+
+    def proxy():
+        p = impl.ThreadLocalProxy()
+        impl.ThreadLocalProxy.set(p, abs)
+        return p
+
+    return [
+        ("partial", lambda: impl.partial(operator.add, 1), (2,)),
+        ("compose", lambda: impl.compose(abs, operator.neg), (3,)),
+        ("composeN", lambda: impl.composeN(operator.neg, abs, operator.neg), (3,)),
+        ("dispatch", lambda: impl.dispatch(_is_str, len, _is_int, abs, repr), (3,)),
+        ("dispatch_types", lambda: impl.dispatch(
+            impl.isinstanceof(str), len, impl.isinstanceof(int), abs, repr), (3,)),
+        ("and_predicate", lambda: impl.and_predicate(_is_int, bool), (3,)),
+        ("or_predicate", lambda: impl.or_predicate(_is_str, _is_int), (3,)),
+        ("predicate_tree", lambda: impl.and_predicate(
+            impl.or_predicate(impl.isinstanceof(str), impl.isinstanceof(int)),
+            impl.not_predicate(impl.isinstanceof(bool))), (3,)),
+        ("predicate_tree_compiled", lambda: impl.compile_predicate(impl.and_predicate(
+            impl.or_predicate(impl.isinstanceof(str), impl.isinstanceof(int)),
+            impl.not_predicate(impl.isinstanceof(bool)))), (3,)),
+        ("and_predicate_adaptive", lambda: impl.and_predicate(
+            _is_not_none, impl.isinstanceof(str), adaptive=True), (3,)),
+        ("if_then_else", lambda: impl.if_then_else(_is_int, abs, repr), (3,)),
+        ("constantly", lambda: impl.constantly(1), ()),
+        ("memoize_one_arg_hit", memo, (_KEY,)),
+        ("cache_hit", cache, (_KEY,)),
+        ("walker", lambda: impl.walker(abs), (_NESTED,)),
+        ("threadlocal_proxy", proxy, (3,)),
+    ]
+
+
+def _reference_cases():
+    memo = functools.lru_cache(maxsize=None)(id)
+    memo(_KEY)
+
+    table = {_KEY: id(_KEY)}
+
+    local = threading.local()
+    local.target = abs
+
+    def dispatch(x):
+        if _is_str(x):
+            return len(x)
+        if _is_int(x):
+            return abs(x)
+        return repr(x)
+
+    def walk(obj):
+        if isinstance(obj, (list, tuple)):
+            return type(obj)(walk(x) for x in obj)
+        if isinstance(obj, dict):
+            return {k: walk(v) for k, v in obj.items()}
+        return abs(obj)
+
+    cases = [
+        ("partial", functools.partial(operator.add, 1), (2,)),
+        ("compose", lambda x: abs(operator.neg(x)), (3,)),
+        ("composeN", lambda x: operator.neg(abs(operator.neg(x))), (3,)),
+        ("dispatch", dispatch, (3,)),
+        ("dispatch_types", lambda x: len(x) if isinstance(x, str) else abs(x) if isinstance(x, int) else repr(x), (3,)),
+        ("and_predicate", lambda x: _is_int(x) and bool(x), (3,)),
+        ("or_predicate", lambda x: _is_str(x) or _is_int(x), (3,)),
+        ("predicate_tree", lambda x: isinstance(x, (str, int)) and not isinstance(x, bool), (3,)),
+        ("predicate_tree_compiled", lambda x: isinstance(x, (str, int)) and not isinstance(x, bool), (3,)),
+        ("and_predicate_adaptive", lambda x: isinstance(x, str) and _is_not_none(x), (3,)),
+        ("if_then_else", lambda x: abs(x) if _is_int(x) else repr(x), (3,)),
+        ("constantly", lambda: 1, ()),
+        ("memoize_one_arg_hit", memo, (_KEY,)),
+        ("cache_hit", table.get, (_KEY,)),
+        ("walker", walk, (_NESTED,)),
+        ("threadlocal_proxy", lambda x: local.target(x), (3,)),
+    ]
+    return [(name, lambda func=func: func, args) for name, func, args in cases]
+
+
+def _add_cmdline_args(cmd, args):
+    cmd.extend(("--variant", args.variant))
+
+
+def main():
+    runner = pyperf.Runner(add_cmdline_args=_add_cmdline_args)
+    runner.argparser.add_argument(
+        "--variant", choices=VARIANTS + ("all",), default="all",
+        help="implementation to benchmark (default: all)")
+    args = runner.parse_args()
+
+    variants = VARIANTS if args.variant == "all" else (args.variant,)
+
+    runner.metadata["functional_backend"] = fn.__backend__
+
+    for variant in variants:
+        if variant == "native":
+            if not fn.__backend__.startswith("native"):
+                continue
+            cases = _cases(fn._backend_mod)
+        elif variant == "pure":
+            cases = _cases(_pure)
+        else:
+            cases = _reference_cases()
+
+        for name, factory, call_args in cases:
+            try:
+                func = factory()
+            except TypeError:
+                # not constructible with this backend
+                continue
+            runner.bench_time_func(
+                f"{name}[{variant}]", _CALLERS[len(call_args)], func, *call_args,
+                inner_loops=INNER_LOOPS)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,291 @@
+// Native microbenchmark for the retracesoftware.functional combinators.
+//
+// Calls each combinator through its vectorcall slot in a tight C++ loop, so
+// the numbers are the combinator's own per-call cost with no interpreter
+// dispatch on top. Where a case has a direct equivalent (the wrapped target
+// called with the same effective arguments) that is timed too, and the
+// difference is reported as overhead_ns.
+//
+//   vectorcall_bench [--min-time SECONDS] [--repeat N] [-o FILE] [CASE...]
+//
+// The module under test is imported as retracesoftware.functional, so set
+// PYTHONPATH to the build being measured. Results are written as JSON.
+
+#include <Python.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Case {
+    const char * name;
+    const char * target;        // expression evaluated in the prelude namespace
+    const char * args;          // tuple of positional arguments
+    const char * baseline;      // direct equivalent, or nullptr
+    const char * baseline_args;
+};
+
+const char * prelude =
+    "import operator\n"
+    "import retracesoftware.functional as fn\n"
+    "KEY = object()\n"
+    "ITEMS = list(range(-500, 500))\n"
+    "NEG_ABS = fn.compose(abs, operator.neg)\n"
+    "INT_NOT_BOOL = fn.and_predicate(fn.isinstanceof(int), fn.not_predicate(fn.isinstanceof(bool)))\n"
+    "NESTED = {'a': [1, 2, (3, 4)], 'b': ({'c': 5}, [6, [7, 8]]), 'd': 9}\n"
+    "def is_int(x): return type(x) is int\n"
+    "def is_str(x): return type(x) is str\n"
+    "def keyed(x, sep=None): return x\n"
+    "PROXY = fn.ThreadLocalProxy()\n"
+    "def warm(f, *args):\n"
+    "    f(*args)\n"
+    "    return f\n"
+    "def bound(proxy, target):\n"
+    "    fn.ThreadLocalProxy.set(proxy, target)\n"
+    "    return proxy\n";
+
+const Case cases[] = {
+    {"partial", "fn.partial(operator.add, 1)", "(2,)", "operator.add", "(1, 2)"},
+    {"partial_required", "fn.partial(operator.add, 1, required=1)", "(2,)", "operator.add", "(1, 2)"},
+    {"mapargs_partial", "fn.mapargs(fn.partial(operator.add, 1), abs)", "(2,)", nullptr, nullptr},
+    {"partial_kwargs", "fn.partial(keyed, sep='-')", "(1,)", "__import__('functools').partial(keyed, sep='-')", "(1,)"},
+    {"partial_nested", "fn.partial(fn.partial(operator.add), 1)", "(2,)", "operator.add", "(1, 2)"},
+    {"partial_placeholder", "fn.partial(operator.sub, fn.Placeholder, 1)", "(2,)", "operator.sub", "(2, 1)"},
+    {"compose", "fn.compose(abs, operator.neg)", "(3,)", nullptr, nullptr},
+    {"composeN", "fn.composeN(operator.neg, abs, operator.neg)", "(3,)", nullptr, nullptr},
+    {"dispatch", "fn.dispatch(is_str, len, is_int, abs, repr)", "(3,)", nullptr, nullptr},
+    {"dispatch_types", "fn.dispatch(fn.isinstanceof(str), len, fn.isinstanceof(int), abs, repr)", "(3,)", nullptr, nullptr},
+    {"and_predicate", "fn.and_predicate(is_int, bool)", "(3,)", nullptr, nullptr},
+    {"or_predicate", "fn.or_predicate(is_str, is_int)", "(3,)", nullptr, nullptr},
+    {"predicate_tree", "fn.and_predicate(fn.or_predicate(fn.isinstanceof(str), fn.isinstanceof(int)), "
+                       "fn.not_predicate(fn.isinstanceof(bool)))", "(3,)", nullptr, nullptr},
+    {"predicate_tree_compiled", "fn.compile_predicate(fn.and_predicate(fn.or_predicate(fn.isinstanceof(str), "
+                                "fn.isinstanceof(int)), fn.not_predicate(fn.isinstanceof(bool))))", "(3,)", nullptr, nullptr},
+    {"and_predicate_slow_first", "fn.and_predicate(lambda x: x is not None, fn.isinstanceof(str))", "(3,)", nullptr, nullptr},
+    {"and_predicate_adaptive", "fn.and_predicate(lambda x: x is not None, fn.isinstanceof(str), adaptive=True)", "(3,)", nullptr, nullptr},
+    {"map_batch", "fn.partial(fn.map_batch, NEG_ABS)", "(ITEMS,)", "lambda xs: list(map(NEG_ABS, xs))", "(ITEMS,)"},
+    {"filter_batch", "fn.partial(fn.filter_batch, INT_NOT_BOOL)", "(ITEMS,)", "lambda xs: list(filter(INT_NOT_BOOL, xs))", "(ITEMS,)"},
+    {"if_then_else", "fn.if_then_else(is_int, abs, repr)", "(3,)", nullptr, nullptr},
+    {"constantly", "fn.constantly(1)", "()", nullptr, nullptr},
+    {"memoize_one_arg_hit", "warm(fn.memoize_one_arg(id), KEY)", "(KEY,)", "id", "(KEY,)"},
+    {"memoize_hit", "warm(fn.memoize(id), KEY)", "(KEY,)", "id", "(KEY,)"},
+    {"cache_hit", "warm(fn.Cache(id), KEY)", "(KEY,)", "id", "(KEY,)"},
+    {"walker", "fn.walker(abs)", "(NESTED,)", nullptr, nullptr},
+    {"typed_walker", "fn.typed_walker(bytes, bytes.upper)", "(NESTED,)", nullptr, nullptr},
+    {"deepwrap", "fn.deepwrap(fn.identity, fn.constantly(abs))", "()", nullptr, nullptr},
+    {"threadlocal_swap", "fn.ThreadLocalProxy.swap", "(PROXY, abs)", nullptr, nullptr},
+    {"threadlocal_proxy", "bound(fn.ThreadLocalProxy(), abs)", "(3,)", "abs", "(3,)"},
+};
+
+struct Callable {
+    PyObject * callable = nullptr;
+    PyObject * args = nullptr;     // tuple
+
+    ~Callable() {
+        Py_XDECREF(callable);
+        Py_XDECREF(args);
+    }
+};
+
+struct Result {
+    std::string name;
+    double ns_per_call;            // best of the repeats
+    double median_ns;
+    double baseline_ns;            // < 0 when the case has no baseline
+    size_t iterations;
+};
+
+bool build(PyObject * ns, const char * target, const char * args, Callable & out) {
+    out.callable = PyRun_String(target, Py_eval_input, ns, ns);
+    if (!out.callable) return false;
+
+    out.args = PyRun_String(args, Py_eval_input, ns, ns);
+    if (!out.args) return false;
+
+    if (!PyTuple_Check(out.args)) {
+        PyErr_Format(PyExc_TypeError, "arguments for %s must be a tuple", target);
+        return false;
+    }
+    return true;
+}
+
+// Seconds taken by `iterations` calls through the vectorcall slot, or < 0
+// with a Python error set.
+double run(Callable const & c, size_t iterations) {
+    vectorcallfunc call = PyVectorcall_Function(c.callable);
+    if (!call) call = PyObject_Vectorcall;
+
+    PyObject * const * args = &PyTuple_GET_ITEM(c.args, 0);
+    size_t nargs = (size_t)PyTuple_GET_SIZE(c.args);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < iterations; i++) {
+        PyObject * result = call(c.callable, args, nargs, nullptr);
+        if (!result) return -1;
+        Py_DECREF(result);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Grows the iteration count until one run takes at least min_time.
+size_t calibrate(Callable const & c, double min_time) {
+    size_t iterations = 1000;
+
+    for (;;) {
+        double elapsed = run(c, iterations);
+        if (elapsed < 0) return 0;
+        if (elapsed >= min_time || iterations >= ((size_t)1 << 40)) return iterations;
+        iterations *= elapsed > 0 ? std::max<size_t>(2, (size_t)(min_time / elapsed) + 1) : 10;
+    }
+}
+
+// Per-call nanoseconds for each repeat, sorted ascending.
+bool measure(Callable const & c, size_t iterations, int repeat, std::vector<double> & samples) {
+    samples.clear();
+
+    for (int r = 0; r < repeat; r++) {
+        double elapsed = run(c, iterations);
+        if (elapsed < 0) return false;
+        samples.push_back(elapsed * 1e9 / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+    return true;
+}
+
+bool selected(const char * name, std::vector<const char *> const & filter) {
+    if (filter.empty()) return true;
+
+    for (const char * f : filter) {
+        if (!strcmp(f, name)) return true;
+    }
+    return false;
+}
+
+void write_json(FILE * out, std::vector<Result> const & results, const char * backend, double min_time, int repeat) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"python\": \"%s\",\n", PY_VERSION);
+    fprintf(out, "  \"backend\": \"%s\",\n", backend);
+    fprintf(out, "  \"min_time\": %g,\n", min_time);
+    fprintf(out, "  \"repeat\": %d,\n", repeat);
+    fprintf(out, "  \"results\": [");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        Result const & r = results[i];
+
+        fprintf(out, "%s\n    {\"name\": \"%s\", \"ns_per_call\": %.3f, \"median_ns\": %.3f, \"iterations\": %zu",
+                i ? "," : "", r.name.c_str(), r.ns_per_call, r.median_ns, r.iterations);
+
+        if (r.baseline_ns >= 0) {
+            fprintf(out, ", \"baseline_ns\": %.3f, \"overhead_ns\": %.3f", r.baseline_ns, r.ns_per_call - r.baseline_ns);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+int usage(const char * argv0) {
+    fprintf(stderr, "usage: %s [--min-time SECONDS] [--repeat N] [-o FILE] [CASE...]\n\ncases:", argv0);
+    for (Case const & c : cases) fprintf(stderr, " %s", c.name);
+    fprintf(stderr, "\n");
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char ** argv) {
+    double min_time = 0.1;
+    int repeat = 5;
+    const char * output = nullptr;
+    std::vector<const char *> filter;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            min_time = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+            output = argv[++i];
+        } else if (argv[i][0] == '-') {
+            return usage(argv[0]);
+        } else {
+            filter.push_back(argv[i]);
+        }
+    }
+
+    Py_Initialize();
+
+    PyObject * ns = PyDict_New();
+    if (!ns || PyDict_SetItemString(ns, "__builtins__", PyEval_GetBuiltins()) < 0) {
+        PyErr_Print();
+        return 1;
+    }
+
+    PyObject * ok = PyRun_String(prelude, Py_file_input, ns, ns);
+    if (!ok) {
+        PyErr_Print();
+        return 1;
+    }
+    Py_DECREF(ok);
+
+    std::string backend = "unknown";
+    PyObject * b = PyRun_String("fn.__backend__", Py_eval_input, ns, ns);
+    if (b && PyUnicode_Check(b)) backend = PyUnicode_AsUTF8(b);
+    Py_XDECREF(b);
+    PyErr_Clear();
+
+    std::vector<Result> results;
+    std::vector<double> samples;
+
+    for (Case const & c : cases) {
+        if (!selected(c.name, filter)) continue;
+
+        Callable target, baseline;
+
+        if (!build(ns, c.target, c.args, target) ||
+            (c.baseline && !build(ns, c.baseline, c.baseline_args, baseline))) {
+            // not constructible with this backend
+            fprintf(stderr, "skipping %s: ", c.name);
+            PyErr_Print();
+            continue;
+        }
+
+        size_t iterations = calibrate(target, min_time);
+
+        if (!iterations || !measure(target, iterations, repeat, samples)) {
+            fprintf(stderr, "%s failed: ", c.name);
+            PyErr_Print();
+            continue;
+        }
+
+        Result r = {c.name, samples.front(), samples[samples.size() / 2], -1, iterations};
+
+        if (c.baseline) {
+            if (!measure(baseline, iterations, repeat, samples)) {
+                fprintf(stderr, "%s baseline failed: ", c.name);
+                PyErr_Print();
+                continue;
+            }
+            r.baseline_ns = samples.front();
+        }
+        fprintf(stderr, "%-24s %10.1f ns\n", r.name.c_str(), r.ns_per_call);
+        results.push_back(r);
+    }
+
+    FILE * out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        perror(output);
+        return 1;
+    }
+    write_json(out, results, backend.c_str(), min_time, repeat);
+    if (output) fclose(out);
+
+    Py_DECREF(ns);
+    return Py_FinalizeEx() < 0 ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+#include "functional.h"
+#include <vector>
+
+// Bulk application of a callable over a sequence. The sequence is taken as
+// a tuple, which a tuple already is and a list is copied into, so callbacks
+// that mutate the list cannot pull items out from under the loop. The
+// callable is resolved to its vectorcall once, leaving one indirect call
+// per item.
+
+static PyObject * snapshot(PyObject * seq) {
+    return PyTuple_CheckExact(seq) ? Py_NewRef(seq) : PySequence_Tuple(seq);
+}
+
+PyObject * map_batch(PyObject * function, PyObject * seq) {
+    if (!PyCallable_Check(function)) {
+        PyErr_Format(PyExc_TypeError, "map_batch() expects a callable, got %S", Py_TYPE(function));
+        return nullptr;
+    }
+
+    PyObject * items = snapshot(seq);
+    if (!items) return nullptr;
+
+    retracesoftware::FastCall call(function);
+    // owned; the list is built once every value is in, so the collector
+    // never walks one half filled while a callback runs
+    std::vector<PyObject *> values;
+    values.reserve(PyTuple_GET_SIZE(items));
+
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(items); i++) {
+        PyObject * value = call(PyTuple_GET_ITEM(items, i));
+
+        if (!value) {
+            for (PyObject * done : values) Py_DECREF(done);
+            Py_DECREF(items);
+            return nullptr;
+        }
+        values.push_back(value);
+    }
+    Py_DECREF(items);
+
+    PyObject * result = PyList_New(values.size());
+
+    if (result) {
+        for (size_t i = 0; i < values.size(); i++) {
+            PyList_SET_ITEM(result, i, values[i]);
+        }
+    } else {
+        for (PyObject * value : values) Py_DECREF(value);
+    }
+    return result;
+}
+
+PyObject * filter_batch(PyObject * pred, PyObject * seq) {
+    if (!PyCallable_Check(pred)) {
+        PyErr_Format(PyExc_TypeError, "filter_batch() expects a callable, got %S", Py_TYPE(pred));
+        return nullptr;
+    }
+
+    PyObject * items = snapshot(seq);
+    if (!items) return nullptr;
+
+    Predicate test(pred);
+    std::vector<PyObject *> kept;      // borrowed from items
+
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(items); i++) {
+        PyObject * item = PyTuple_GET_ITEM(items, i);
+
+        switch (test(&item, 1, nullptr)) {
+            case 1: kept.push_back(item); break;
+            case 0: break;
+            default:
+                Py_DECREF(items);
+                return nullptr;
+        }
+    }
+
+    PyObject * result = PyList_New(kept.size());
+
+    if (result) {
+        for (size_t i = 0; i < kept.size(); i++) {
+            PyList_SET_ITEM(result, i, Py_NewRef(kept[i]));
+        }
+    }
+    Py_DECREF(items);
+    return result;
+}
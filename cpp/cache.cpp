@@ -0,0 +1,404 @@
+#include "functional.h"
+#include "object.h"
+#include "pyerrors.h"
+#include <structmember.h>
+#include <chrono>
+#include <mutex>
+#include <cmath>
+#include <cstdint>
+#include "unordered_dense.h"
+
+using namespace ankerl::unordered_dense;
+
+// Cached lookup result. Negative (None) results are only stored when the
+// cache was built with negative_ttl, and carry the steady-clock deadline
+// after which they are looked up again. Positive results never expire, so
+// a positive hit does not read the clock.
+struct Entry {
+    PyObject * value;
+    int64_t expires;    // steady_clock nanoseconds, 0 when the entry never expires
+};
+
+// Longest finite negative_ttl, so a deadline stays well inside int64_t.
+static constexpr int64_t max_ttl_ns = INT64_MAX / 2;
+
+static inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// One independently locked partition of the table; with the GIL there is a
+// single shard.
+struct CacheShard {
+    ShardLock lock;
+    map<PyObject *, Entry> entries;
+    CacheStats stats;
+};
+
+struct Cache {
+    PyObject_HEAD
+    CacheShard shards[CACHE_SHARDS];
+    PyObject * m_lookup;
+    int64_t negative_ttl;   // < 0: don't cache None, 0: cache None forever, > 0: ns
+    vectorcallfunc vectorcall;
+
+    CacheShard & shard(PyObject * key) {
+        if (CACHE_SHARDS == 1) return shards[0];
+        return shards[shard_index(hash<PyObject *>{}(key), CACHE_SHARDS)];
+    }
+
+    size_t size() {
+        size_t n = 0;
+        for (auto & shard : shards) {
+            std::lock_guard<ShardLock> guard(shard.lock);
+            n += shard.entries.size();
+        }
+        return n;
+    }
+
+    int traverse(visitproc visit, void* arg) {
+        Py_VISIT(m_lookup);
+
+        for (auto & shard : shards) {
+            for (auto it = shard.entries.begin(); it != shard.entries.end(); it++) {
+                Py_VISIT(it->first);
+                Py_VISIT(it->second.value);
+            }
+        }
+
+        return 0;
+    }
+
+    // Drop every entry. Each shard's map is swapped out under its lock and
+    // released afterwards, so any code run by the decrefs sees an empty,
+    // consistent cache.
+    void release_all() {
+        for (auto & shard : shards) {
+            map<PyObject *, Entry> old;
+            {
+                std::lock_guard<ShardLock> guard(shard.lock);
+                old = std::move(shard.entries);
+            }
+            for (auto it = old.begin(); it != old.end(); it++) {
+                Py_DECREF(it->first);
+                Py_DECREF(it->second.value);
+            }
+        }
+    }
+
+    int clear() {
+        release_all();
+        Py_CLEAR(m_lookup);
+        return 0;
+    }
+
+    int64_t deadline(PyObject * item) const {
+        if (item != Py_None || negative_ttl <= 0) return 0;
+
+        int64_t now = now_ns();
+        return now > INT64_MAX - negative_ttl ? INT64_MAX : now + negative_ttl;
+    }
+
+    // Inserts or replaces key -> item, taking new references to both.
+    void store(PyObject * key, PyObject * item, int64_t expires) {
+        CacheShard & shard = this->shard(key);
+        PyObject * old = nullptr;
+
+        {
+            std::lock_guard<ShardLock> guard(shard.lock);
+
+            auto [it, inserted] = shard.entries.try_emplace(key, Entry{item, expires});
+
+            if (inserted) {
+                Py_INCREF(key);
+                Py_INCREF(item);
+            } else {
+                old = it->second.value;
+                it->second = Entry{Py_NewRef(item), expires};
+            }
+        }
+        Py_XDECREF(old);
+    }
+
+    PyObject * call(PyObject * obj) {
+        CacheShard & shard = this->shard(obj);
+        PyObject * expired_key = nullptr, * expired_value = nullptr;
+
+        {
+            std::lock_guard<ShardLock> guard(shard.lock);
+
+            auto it = shard.entries.find(obj);
+
+            if (it != shard.entries.end()) {
+                if (!it->second.expires || now_ns() < it->second.expires) {
+                    shard.stats.hit();
+                    return Py_NewRef(it->second.value);
+                }
+                expired_key = it->first;
+                expired_value = it->second.value;
+                shard.entries.erase(it);
+                shard.stats.evict();
+            }
+            shard.stats.miss();
+        }
+        Py_XDECREF(expired_key);
+        Py_XDECREF(expired_value);
+
+        PyObject * item = PyObject_CallOneArg(m_lookup, obj);
+
+        if (!item) return nullptr;
+
+        if (item != Py_None || negative_ttl >= 0) {
+            store(obj, item, deadline(item));
+        }
+        return item;
+    }
+
+    Cache(PyObject * lookup, int64_t negative_ttl, vectorcallfunc vectorcall) :
+        m_lookup(Py_NewRef(lookup)), negative_ttl(negative_ttl), vectorcall(vectorcall)  {}
+    ~Cache() {}
+};
+
+static PyObject * prefill(Cache * self, PyObject * mapping) {
+    PyObject * items;
+
+    if (PyDict_Check(mapping)) {
+        PyObject * key, * value;
+
+        Py_BEGIN_CRITICAL_SECTION(mapping);
+
+        Py_ssize_t n = PyDict_GET_SIZE(mapping) / CACHE_SHARDS + 1;
+
+        for (auto & shard : self->shards) {
+            std::lock_guard<ShardLock> guard(shard.lock);
+            shard.entries.reserve(shard.entries.size() + n);
+        }
+
+        Py_ssize_t pos = 0;
+
+        while (PyDict_Next(mapping, &pos, &key, &value)) {
+            self->store(key, value, self->deadline(value));
+        }
+
+        Py_END_CRITICAL_SECTION();
+        Py_RETURN_NONE;
+    }
+
+    items = PyMapping_Items(mapping);
+    if (!items) return nullptr;
+
+    Py_ssize_t n = PyList_GET_SIZE(items) / CACHE_SHARDS + 1;
+
+    for (auto & shard : self->shards) {
+        std::lock_guard<ShardLock> guard(shard.lock);
+        shard.entries.reserve(shard.entries.size() + n);
+    }
+
+    for (Py_ssize_t i = 0; i < PyList_GET_SIZE(items); i++) {
+        PyObject * pair = PyList_GET_ITEM(items, i);
+
+        if (!PyTuple_Check(pair) || PyTuple_GET_SIZE(pair) != 2) {
+            Py_DECREF(items);
+            PyErr_SetString(PyExc_TypeError, "prefill expects a mapping whose items() yields (key, value) pairs");
+            return nullptr;
+        }
+        PyObject * value = PyTuple_GET_ITEM(pair, 1);
+        self->store(PyTuple_GET_ITEM(pair, 0), value, self->deadline(value));
+    }
+    Py_DECREF(items);
+    Py_RETURN_NONE;
+}
+
+static PyObject * invalidate(Cache * self, PyObject * key) {
+    CacheShard & shard = self->shard(key);
+    PyObject * stored, * value;
+
+    {
+        std::lock_guard<ShardLock> guard(shard.lock);
+
+        auto it = shard.entries.find(key);
+
+        if (it == shard.entries.end()) Py_RETURN_FALSE;
+
+        stored = it->first;
+        value = it->second.value;
+        shard.entries.erase(it);
+    }
+    Py_DECREF(stored);
+    Py_DECREF(value);
+    Py_RETURN_TRUE;
+}
+
+static PyObject * clear_impl(Cache * self, PyObject * unused) {
+    self->release_all();
+    Py_RETURN_NONE;
+}
+
+static PyObject * cache_info_impl(Cache * self, PyObject * unused) {
+    CacheStats stats;
+    size_t size = 0, bytes = 0;
+
+    for (auto & shard : self->shards) {
+        std::lock_guard<ShardLock> guard(shard.lock);
+
+        stats += shard.stats;
+        size += shard.entries.size();
+        bytes += map_bytes(shard.entries);
+    }
+    return cache_info(stats, size, -1, bytes);
+}
+
+static Py_ssize_t length(Cache * self) {
+    return self->size();
+}
+
+static int contains(Cache * self, PyObject * key) {
+    CacheShard & shard = self->shard(key);
+    std::lock_guard<ShardLock> guard(shard.lock);
+
+    auto it = shard.entries.find(key);
+    return it != shard.entries.end() && (!it->second.expires || now_ns() < it->second.expires);
+}
+
+static PyMethodDef methods[] = {
+    {"prefill", (PyCFunction)prefill, METH_O,
+     "prefill(mapping)\n--\n\n"
+     "Bulk load key -> value entries, replacing existing ones.\n\n"
+     "Bucket capacity is reserved once for the whole mapping. None values\n"
+     "are stored as negative entries, expiring after negative_ttl if set."},
+    {"invalidate", (PyCFunction)invalidate, METH_O,
+     "invalidate(key)\n--\n\n"
+     "Drop the entry for key. Returns True if an entry was removed."},
+    {"clear", (PyCFunction)clear_impl, METH_NOARGS,
+     "clear()\n--\n\n"
+     "Drop all entries."},
+    {"cache_info", (PyCFunction)cache_info_impl, METH_NOARGS,
+     "cache_info()\n--\n\n"
+     "Return a dict of cache counters: hits, misses, evictions (expired\n"
+     "negative entries), size and approximate bytes held by the table."},
+    {NULL}  // Sentinel
+};
+
+static PyObject * vectorcall(Cache * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    int nargs = PyVectorcall_NARGS(nargsf);
+
+    if (nargs != 1 || kwnames) {
+        PyErr_SetString(PyExc_TypeError, "Cache takes a single positional parameter");
+        return nullptr;
+    }
+    return self->call(args[0]);
+}
+
+static PyObject* create(PyTypeObject* type, PyObject* args, PyObject* kwds) {
+
+    PyObject * lookup;
+    PyObject * ttl = nullptr;
+
+    static const char* kwlist[] = {"lookup", "negative_ttl", NULL};  // Keywords allowed
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O", (char **)kwlist, &lookup, &ttl)) {
+        return NULL;  // Return NULL to propagate the parsing error
+    }
+
+    if (!PyCallable_Check(lookup)) {
+        PyErr_Format(PyExc_TypeError, "Cache lookup must be callable, got %S", lookup);
+        return NULL;
+    }
+
+    int64_t negative_ttl = -1;
+
+    if (ttl && ttl != Py_None) {
+        double seconds = PyFloat_AsDouble(ttl);
+        if (seconds == -1.0 && PyErr_Occurred()) return NULL;
+
+        if (!(seconds > 0)) {
+            PyErr_Format(PyExc_ValueError, "negative_ttl must be None or a positive number of seconds, not %S", ttl);
+            return NULL;
+        }
+        if (std::isinf(seconds)) {
+            negative_ttl = 0;
+        } else {
+            // 0 means forever, so a finite ttl is at least a nanosecond
+            double ns = seconds * 1e9;
+            negative_ttl = ns < 1 ? 1 : ns >= (double)max_ttl_ns ? max_ttl_ns : (int64_t)ns;
+        }
+    }
+
+    Cache* self = (Cache *)type->tp_alloc(type, 0);
+
+    if (!self) {
+        return NULL;
+    }
+
+    try {
+        new (self) Cache(lookup, negative_ttl, reinterpret_cast<vectorcallfunc>(vectorcall));
+    } catch (...) {
+        Py_DECREF(self);
+        return NULL;
+    }
+
+    return (PyObject *)self;
+}
+
+static void dealloc(Cache *self) {
+    PyObject_GC_UnTrack(self);
+    self->clear();
+    self->~Cache();
+    Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
+}
+
+static int traverse(Cache* self, visitproc visit, void* arg) {
+    return self->traverse(visit, arg);
+}
+
+static int clear(Cache* self) {
+    return self->clear();
+}
+
+static PyObject * repr(Cache * self) {
+    return PyUnicode_FromFormat(MODULE "Cache(%R, size = %zd)", self->m_lookup, (Py_ssize_t)self->size());
+}
+
+static PyMemberDef members[] = {
+    {"lookup", T_OBJECT, offsetof(Cache, m_lookup), READONLY, "The lookup function called on a miss."},
+    {NULL}  /* Sentinel */
+};
+
+static PySequenceMethods sequence = {
+    .sq_length = (lenfunc)length,
+    .sq_contains = (objobjproc)contains,
+};
+
+PyTypeObject Cache_Type = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE "Cache",
+    .tp_basicsize = sizeof(Cache),
+    .tp_itemsize = 0,
+    .tp_dealloc = (destructor)dealloc,
+    .tp_vectorcall_offset = offsetof(Cache, vectorcall),
+    .tp_repr = (reprfunc)repr,
+    .tp_as_sequence = &sequence,
+    .tp_call = PyVectorcall_Call,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_HAVE_VECTORCALL,
+    .tp_doc = "Cache(lookup, negative_ttl=None)\n--\n\n"
+               "A simple identity-based cache with a lookup fallback.\n\n"
+               "On cache miss, calls the lookup function. If lookup returns None,\n"
+               "the result is not cached unless negative_ttl is given. Keys are held\n"
+               "by strong reference. Uses a high-performance C++ hash map.\n\n"
+               "Args:\n"
+               "    lookup: A callable(obj) that returns the value to cache, or None.\n"
+               "    negative_ttl: Seconds to cache None results for (float('inf')\n"
+               "                  to cache them indefinitely), or None to never\n"
+               "                  cache them.\n\n"
+               "Returns:\n"
+               "    A callable that caches and returns lookup results.\n\n"
+               "Example:\n"
+               "    >>> proxy_type = Cache(find_proxy_type, negative_ttl=5.0)\n"
+               "    >>> proxy_type.prefill({int: None, str: None})\n"
+               "    >>> proxy_type(dict)  # looked up, then cached",
+    .tp_traverse = (traverseproc)traverse,
+    .tp_clear = (inquiry)clear,
+    .tp_methods = methods,
+    .tp_members = members,
+    .tp_new = create,
+};
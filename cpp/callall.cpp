@@ -19,13 +19,21 @@ static PyObject * vectorcall(CallAll * self, PyObject** args, size_t nargsf, PyO
         return PyObject_Vectorcall(PyTuple_GET_ITEM(self->_functions, n - 1), args, nargsf, kwnames);
 
     } else if (Py_TYPE(self->_functions) == &PyList_Type) {
-        size_t n = PyList_GET_SIZE(self->_functions);
-        for (size_t i = 0; i < n - 1; i++) {
-            PyObject * res = PyObject_Vectorcall(PyList_GET_ITEM(self->_functions, i), args, nargsf, kwnames);
-            Py_XDECREF(res);
+        // The list stays live: the functions, or other threads on
+        // free-threaded builds, may change it while we iterate, so the size
+        // is re-read each step and each function is held across its call.
+        PyObject * res = Py_NewRef(Py_None);
+
+        for (Py_ssize_t i = 0; i < PyList_GET_SIZE(self->_functions); i++) {
+            PyObject * function = list_get_ref(self->_functions, i);
+            if (!function) break;
+
+            Py_DECREF(res);
+            res = PyObject_Vectorcall(function, args, nargsf, kwnames);
+            Py_DECREF(function);
             if (!res) return NULL;
         }
-        return PyObject_Vectorcall(PyList_GET_ITEM(self->_functions, n - 1), args, nargsf, kwnames);
+        return res;
     }
     Py_RETURN_NONE;
 }
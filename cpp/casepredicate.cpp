@@ -2,6 +2,8 @@
 #include "object.h"
 #include "pyerrors.h"
 #include <structmember.h>
+#include "unordered_dense.h"
+#include <mutex>
 
 struct Pair {
     vectorcallfunc vectorcall;
@@ -9,30 +11,91 @@ struct Pair {
 };
 
 struct IfThen {
-    Pair test;
+    Predicate test;
     Pair then;
 };
 
+// Routes for the leading run of tests that only look at the argument's type
+// (isinstanceof, TypePredicate). Each type seen is resolved once to the
+// first of those tests it passes, or to `ntyped` when it passes none and
+// the scan carries on with the remaining, opaque tests.
+//
+// Entries are stamped with the type's version tag, which changes whenever
+// its MRO can have, so a reassigned __bases__ or a new type at a recycled
+// address never hits a stale route. Types without a tag are resolved on
+// every call.
+struct TypeRoutes {
+    struct Route {
+        unsigned int version;
+        Py_ssize_t index;
+    };
+
+    static constexpr size_t max_types = 1024;
+
+    ShardLock lock;
+    ankerl::unordered_dense::map<PyTypeObject *, Route> routes;
+    Py_ssize_t ntyped;
+
+    Py_ssize_t resolve(IfThen * dispatch, PyTypeObject * type) {
+        for (Py_ssize_t i = 0; i < ntyped; i++) {
+            if (type_test(dispatch[i].test.call.callable, type) == 1) return i;
+        }
+        return ntyped;
+    }
+
+    Py_ssize_t route(IfThen * dispatch, PyTypeObject * type) {
+        unsigned int version = type_version_tag(type);
+
+        if (!version) return resolve(dispatch, type);
+
+        {
+            std::lock_guard<ShardLock> guard(lock);
+
+            auto it = routes.find(type);
+            if (it != routes.end() && it->second.version == version) {
+                return it->second.index;
+            }
+        }
+        Py_ssize_t index = resolve(dispatch, type);
+
+        std::lock_guard<ShardLock> guard(lock);
+
+        // dead types are never evicted individually, bound them instead
+        if (routes.size() >= max_types) routes.clear();
+        routes[type] = Route {version, index};
+
+        return index;
+    }
+};
+
 struct CasePredicate : public PyVarObject {
     vectorcallfunc vectorcall;
-    // std::vector<std::pair<PyTypeObject *, PyObject *>> dispatch;
     Pair otherwise;
+    TypeRoutes * routes;        // nullptr when the first test is opaque
     IfThen dispatch[];
 };
 
 static PyObject * vectorcall(CasePredicate * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
 
-    for (size_t i = 0; i < (size_t)self->ob_size; i++) {
+    size_t start = 0;
 
-        IfThen * if_then = self->dispatch + i;
+    // type tests take exactly one positional argument, anything else goes
+    // the slow way so they raise as usual
+    if (self->routes && PyVectorcall_NARGS(nargsf) == 1 && !kwnames) {
+        Py_ssize_t index = self->routes->route(self->dispatch, Py_TYPE(args[0]));
 
-        PyObject * res = if_then->test.vectorcall(if_then->test.callable, args, nargsf, kwnames);
+        if (index < self->routes->ntyped) {
+            IfThen * if_then = self->dispatch + index;
+            return if_then->then.vectorcall(if_then->then.callable, args, nargsf, kwnames);
+        }
+        start = (size_t)index;
+    }
 
-        if (!res) return nullptr;
-        int is_true = PyObject_IsTrue(res);
-        Py_DECREF(res);
+    for (size_t i = start; i < (size_t)self->ob_size; i++) {
 
-        switch (is_true) {
+        IfThen * if_then = self->dispatch + i;
+
+        switch (if_then->test(args, nargsf, kwnames)) {
         case 0: break;
         case 1: return if_then->then.vectorcall(if_then->then.callable, args, nargsf, kwnames);
         default: return nullptr;
@@ -46,7 +109,7 @@ static PyObject * vectorcall(CasePredicate * self, PyObject** args, size_t nargs
 
 static int traverse(CasePredicate* self, visitproc visit, void* arg) {
     for (size_t i = 0; i < (size_t)self->ob_size; i++) {
-        Py_VISIT(self->dispatch[i].test.callable);
+        Py_VISIT(self->dispatch[i].test.call.callable);
         Py_VISIT(self->dispatch[i].then.callable);
     } 
     Py_VISIT(self->otherwise.callable);
@@ -56,7 +119,7 @@ static int traverse(CasePredicate* self, visitproc visit, void* arg) {
 
 static int clear(CasePredicate* self) {
     for (size_t i = 0; i < (size_t)self->ob_size; i++) {
-        Py_CLEAR(self->dispatch[i].test.callable);
+        Py_CLEAR(self->dispatch[i].test.call.callable);
         Py_CLEAR(self->dispatch[i].then.callable);
     } 
     Py_CLEAR(self->otherwise.callable);
@@ -66,9 +129,18 @@ static int clear(CasePredicate* self) {
 static void dealloc(CasePredicate *self) {
     PyObject_GC_UnTrack(self);          // Untrack from the GC
     clear(self);
+    delete self->routes;
     Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
 }
 
+static PyObject * create(PyTypeObject * type, PyObject * args, PyObject * kwds) {
+    if (kwds && PyDict_GET_SIZE(kwds)) {
+        PyErr_SetString(PyExc_TypeError, "dispatch takes no keyword arguments");
+        return nullptr;
+    }
+    return dispatch(&PyTuple_GET_ITEM(args, 0), PyTuple_GET_SIZE(args));
+}
+
 static PyMemberDef members[] = {
     // {"elements", T_OBJECT, offsetof(CasePredicate, elements), READONLY, "TODO"},
     {NULL}  /* Sentinel */
@@ -88,6 +160,9 @@ PyTypeObject CasePredicate_Type = {
                "Tests predicates in order; on first truthy result, calls the\n"
                "corresponding 'then' function. If no predicate matches and an\n"
                "odd number of args is given, the last arg is called as fallback.\n\n"
+               "Leading isinstanceof/TypePredicate tests are not called at all: each\n"
+               "argument type is resolved once to its branch, so dispatching on them\n"
+               "is a single table lookup. Other tests are evaluated in order.\n\n"
                "Args:\n"
                "    Alternating (test, then) pairs, optionally ending with otherwise.\n\n"
                "Returns:\n"
@@ -96,10 +171,16 @@ PyTypeObject CasePredicate_Type = {
     .tp_clear = (inquiry)clear,
     // .tp_methods = methods,
     .tp_members = members,
+    .tp_new = create,
 };
 
 PyObject * dispatch(PyObject * const * args, size_t nargs) {
 
+    if (nargs < 2) {
+        PyErr_SetString(PyExc_TypeError, "dispatch requires at least one (test, then) pair");
+        return nullptr;
+    }
+
     CasePredicate * self = (CasePredicate *)CasePredicate_Type.tp_alloc(&CasePredicate_Type, (nargs >> 1));
     
     if (!self) {
@@ -107,8 +188,7 @@ PyObject * dispatch(PyObject * const * args, size_t nargs) {
     }
 
     for (size_t pair = 0; pair < (nargs >> 1); pair++) {
-        self->dispatch[pair].test.vectorcall = extract_vectorcall(args[pair * 2]);
-        self->dispatch[pair].test.callable = Py_NewRef(args[pair * 2]);
+        self->dispatch[pair].test = Predicate(Py_NewRef(args[pair * 2]));
         self->dispatch[pair].then.vectorcall = extract_vectorcall(args[(pair * 2) + 1]);
         self->dispatch[pair].then.callable = Py_NewRef(args[(pair * 2) + 1]);
     }
@@ -118,6 +198,16 @@ PyObject * dispatch(PyObject * const * args, size_t nargs) {
     } else {
         self->otherwise.callable = nullptr;
     }
+
+    Py_ssize_t ntyped = 0;
+
+    while (ntyped < Py_SIZE(self) && type_test(self->dispatch[ntyped].test.call.callable, &PyBaseObject_Type) >= 0) {
+        ntyped++;
+    }
+    if (ntyped) {
+        self->routes = new TypeRoutes();
+        self->routes->ntyped = ntyped;
+    }
     self->vectorcall = (vectorcallfunc)vectorcall;
 
     return (PyObject *)self;
@@ -0,0 +1,359 @@
+#include "functional.h"
+#include <structmember.h>
+#include <string>
+#include <vector>
+
+// compile_predicate lowers a tree of this module's predicates into a flat
+// array of tests. Each instruction evaluates one leaf and jumps to one of
+// two targets depending on the outcome, so and/or short-circuiting and
+// not_predicate cost nothing at run time: they only decide where the jumps
+// go. Two targets past the end of the code stand for the final True/False.
+//
+// Leaves the compiler can't see into (Python functions, instance_test, ...)
+// become CALL instructions, evaluated through the native predicate protocol
+// where the callee has one.
+
+enum Opcode : uint8_t {
+    OP_ISINSTANCE,      // PyObject_TypeCheck(arg, type)
+    OP_ISTYPE,          // Py_TYPE(arg) == type
+    OP_CALL,            // opaque predicate
+    OP_CONST,           // constant outcome
+};
+
+struct Instruction {
+    Opcode op;
+    int value;                  // OP_CONST
+    PyTypeObject * type;        // OP_ISINSTANCE, OP_ISTYPE (borrowed from constants)
+    Predicate pred;             // OP_CALL (borrowed from constants)
+    uint32_t on_true;
+    uint32_t on_false;
+};
+
+struct CompiledPredicate : public PyVarObject {
+    vectorcallfunc vectorcall;
+    PyObject * source;          // the predicate compiled
+    PyObject * constants;       // list owning every object the code refers to
+    bool single_arg;            // type tests need exactly one positional argument
+    Instruction code[];
+};
+
+static int evaluate(CompiledPredicate * self, PyObject * const * args, size_t nargsf, PyObject * kwnames) {
+
+    // the type tests raise on anything but one positional argument, the
+    // source tree does that with the right message
+    if (self->single_arg && (PyVectorcall_NARGS(nargsf) != 1 || kwnames)) {
+        return truth(PyObject_Vectorcall(self->source, args, nargsf, kwnames));
+    }
+
+    uint32_t pc = 0;
+    uint32_t end = (uint32_t)Py_SIZE(self);
+
+    while (pc < end) {
+        Instruction & ins = self->code[pc];
+        int status;
+
+        switch (ins.op) {
+            case OP_ISINSTANCE: status = PyObject_TypeCheck(args[0], ins.type); break;
+            case OP_ISTYPE: status = Py_TYPE(args[0]) == ins.type; break;
+            case OP_CALL: status = ins.pred(args, nargsf, kwnames); break;
+            case OP_CONST: status = ins.value; break;
+            default: status = -1; PyErr_SetString(PyExc_SystemError, "bad predicate opcode");
+        }
+        if (status < 0) return -1;
+
+        pc = status ? ins.on_true : ins.on_false;
+    }
+    return pc == end;
+}
+
+int compiledpredicate_test(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames) {
+    return evaluate((CompiledPredicate *)pred, args, nargsf, kwnames);
+}
+
+static PyObject * vectorcall(CompiledPredicate * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    switch (evaluate(self, args, nargsf, kwnames)) {
+        case 0: Py_RETURN_FALSE;
+        case 1: Py_RETURN_TRUE;
+        default: return nullptr;
+    }
+}
+
+namespace {
+
+// Code generation with symbolic labels, resolved once the code is complete.
+// Labels EXIT_TRUE and EXIT_FALSE are the two exits.
+struct Compiler {
+    static constexpr uint32_t EXIT_TRUE = 0;
+    static constexpr uint32_t EXIT_FALSE = 1;
+
+    std::vector<Instruction> code;
+    std::vector<uint32_t> labels = {0, 0};     // label -> pc, exits patched last
+    PyObject * constants;
+    bool single_arg = false;
+
+    uint32_t label() {
+        labels.push_back(0);
+        return (uint32_t)labels.size() - 1;
+    }
+
+    void bind(uint32_t label) { labels[label] = (uint32_t)code.size(); }
+
+    int keep(PyObject * obj) { return PyList_Append(constants, obj); }
+
+    void emit(Instruction ins, uint32_t on_true, uint32_t on_false) {
+        ins.on_true = on_true;
+        ins.on_false = on_false;
+        code.push_back(ins);
+    }
+
+    int type_check(Opcode op, PyTypeObject * type, uint32_t on_true, uint32_t on_false) {
+        if (keep((PyObject *)type) < 0) return -1;
+
+        Instruction ins = {};
+        ins.op = op;
+        ins.type = type;
+        emit(ins, on_true, on_false);
+        single_arg = true;
+        return 0;
+    }
+
+    int many(PyObject * node, bool is_and, uint32_t on_true, uint32_t on_false) {
+        PyObject * elements = ((ManyPredicate *)node)->elements;
+        Py_ssize_t n = PyTuple_GET_SIZE(elements);
+
+        if (n == 0) {
+            Instruction ins = {};
+            ins.op = OP_CONST;
+            ins.value = is_and;
+            emit(ins, on_true, on_false);
+            return 0;
+        }
+        for (Py_ssize_t i = 0; i < n; i++) {
+            PyObject * child = PyTuple_GET_ITEM(elements, i);
+
+            if (i == n - 1) return compile(child, on_true, on_false);
+
+            uint32_t next = label();
+            int status = is_and ? compile(child, next, on_false) : compile(child, on_true, next);
+            if (status < 0) return -1;
+            bind(next);
+        }
+        return 0;
+    }
+
+    int attribute(PyObject * node, const char * name, uint32_t on_true, uint32_t on_false, bool negate) {
+        PyObject * child = PyObject_GetAttrString(node, name);
+        if (!child) return -1;
+
+        int status = keep(child);
+        if (status == 0) {
+            status = negate ? compile(child, on_false, on_true) : compile(child, on_true, on_false);
+        }
+        Py_DECREF(child);
+        return status;
+    }
+
+    int compile(PyObject * node, uint32_t on_true, uint32_t on_false) {
+        PyTypeObject * type = Py_TYPE(node);
+
+        // an adaptive node keeps choosing its own order, so it stays a call
+        bool fixed = (type == &AndPredicate_Type || type == &OrPredicate_Type) && !((ManyPredicate *)node)->adaptive;
+
+        if (fixed && type == &AndPredicate_Type) return many(node, true, on_true, on_false);
+        if (fixed && type == &OrPredicate_Type) return many(node, false, on_true, on_false);
+        if (type == &NotPredicate_Type) return attribute(node, "pred", on_true, on_false, true);
+
+        if (type == &TypePredicate_Type) {
+            return type_check(OP_ISTYPE, ((TypePredicate *)node)->cls, on_true, on_false);
+        }
+
+        PyTypeObject * cls;
+        PyTypeObject * andnot;
+
+        if (type == &InstanceTest_Type && instancetest_types(node, &cls, &andnot)) {
+            if (!andnot) return type_check(OP_ISINSTANCE, cls, on_true, on_false);
+
+            uint32_t next = label();
+            if (type_check(OP_ISINSTANCE, cls, next, on_false) < 0) return -1;
+            bind(next);
+            return type_check(OP_ISINSTANCE, andnot, on_true, on_false);
+        }
+
+        if (type == &Constantly_Type) {
+            PyObject * value = PyObject_GetAttrString(node, "value");
+            if (!value) return -1;
+
+            // only fold values whose truth can't change later
+            bool fold = PyBool_Check(value) || value == Py_None;
+
+            Instruction ins = {};
+            ins.op = OP_CONST;
+            ins.value = value == Py_True;
+            Py_DECREF(value);
+
+            if (fold) {
+                emit(ins, on_true, on_false);
+                return 0;
+            }
+        }
+
+        if (keep(node) < 0) return -1;
+
+        Instruction ins = {};
+        ins.op = OP_CALL;
+        ins.pred = Predicate(node);
+        emit(ins, on_true, on_false);
+        return 0;
+    }
+
+    void resolve() {
+        labels[EXIT_TRUE] = (uint32_t)code.size();
+        labels[EXIT_FALSE] = (uint32_t)code.size() + 1;
+
+        for (Instruction & ins : code) {
+            ins.on_true = labels[ins.on_true];
+            ins.on_false = labels[ins.on_false];
+        }
+    }
+};
+
+}
+
+PyObject * compile_predicate(PyObject * pred) {
+    if (!PyCallable_Check(pred)) {
+        PyErr_Format(PyExc_TypeError, "compile_predicate expects a callable, got %S", pred);
+        return nullptr;
+    }
+
+    Compiler compiler;
+    compiler.constants = PyList_New(0);
+    if (!compiler.constants) return nullptr;
+
+    if (compiler.compile(pred, Compiler::EXIT_TRUE, Compiler::EXIT_FALSE) < 0) {
+        Py_DECREF(compiler.constants);
+        return nullptr;
+    }
+    compiler.resolve();
+
+    CompiledPredicate * self = (CompiledPredicate *)CompiledPredicate_Type.tp_alloc(
+        &CompiledPredicate_Type, compiler.code.size());
+
+    if (!self) {
+        Py_DECREF(compiler.constants);
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < compiler.code.size(); i++) {
+        self->code[i] = compiler.code[i];
+    }
+    self->source = Py_NewRef(pred);
+    self->constants = compiler.constants;
+    self->single_arg = compiler.single_arg;
+    self->vectorcall = (vectorcallfunc)vectorcall;
+
+    return (PyObject *)self;
+}
+
+// padded, PyUnicode_FromFormat has no width flag for strings
+static const char * opnames[] = {"ISINSTANCE", "ISTYPE    ", "CALL      ", "CONST     "};
+
+static PyObject * target(CompiledPredicate * self, uint32_t pc) {
+    Py_ssize_t end = Py_SIZE(self);
+
+    return pc == (uint32_t)end ? PyUnicode_FromString("True")
+         : pc == (uint32_t)end + 1 ? PyUnicode_FromString("False")
+         : PyUnicode_FromFormat("%u", pc);
+}
+
+static PyObject * disassemble(CompiledPredicate * self, PyObject * unused) {
+    PyObject * lines = PyList_New(0);
+    if (!lines) return nullptr;
+
+    for (Py_ssize_t pc = 0; pc < Py_SIZE(self); pc++) {
+        Instruction & ins = self->code[pc];
+
+        PyObject * operand =
+            ins.op == OP_CONST ? PyUnicode_FromString(ins.value ? "True" : "False")
+            : ins.op == OP_CALL ? PyObject_Repr(ins.pred.call.callable)
+            : PyUnicode_FromString(ins.type->tp_name);
+
+        PyObject * on_true = target(self, ins.on_true);
+        PyObject * on_false = target(self, ins.on_false);
+
+        PyObject * line = operand && on_true && on_false
+            ? PyUnicode_FromFormat("%4zd %s %U  true -> %U, false -> %U",
+                                   pc, opnames[ins.op], operand, on_true, on_false)
+            : nullptr;
+
+        Py_XDECREF(operand);
+        Py_XDECREF(on_true);
+        Py_XDECREF(on_false);
+
+        if (!line || PyList_Append(lines, line) < 0) {
+            Py_XDECREF(line);
+            Py_DECREF(lines);
+            return nullptr;
+        }
+        Py_DECREF(line);
+    }
+
+    PyObject * sep = PyUnicode_FromString("\n");
+    PyObject * result = sep ? PyUnicode_Join(sep, lines) : nullptr;
+    Py_XDECREF(sep);
+    Py_DECREF(lines);
+    return result;
+}
+
+static int traverse(CompiledPredicate* self, visitproc visit, void* arg) {
+    Py_VISIT(self->source);
+    Py_VISIT(self->constants);
+    return 0;
+}
+
+static int clear(CompiledPredicate* self) {
+    Py_CLEAR(self->source);
+    Py_CLEAR(self->constants);
+    return 0;
+}
+
+static void dealloc(CompiledPredicate *self) {
+    PyObject_GC_UnTrack(self);          // Untrack from the GC
+    clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
+}
+
+static PyObject * repr(CompiledPredicate *self) {
+    return PyUnicode_FromFormat(MODULE "compile_predicate(%S)", self->source);
+}
+
+static PyMethodDef methods[] = {
+    {"disassemble", (PyCFunction)disassemble, METH_NOARGS,
+     "disassemble()\n--\n\n"
+     "Return the compiled instructions as text, one per line: the test and\n"
+     "where evaluation continues when it passes or fails."},
+    {NULL}  // Sentinel
+};
+
+static PyMemberDef members[] = {
+    {"source", T_OBJECT, OFFSET_OF_MEMBER(CompiledPredicate, source), READONLY, "The predicate that was compiled."},
+    {NULL}  /* Sentinel */
+};
+
+PyTypeObject CompiledPredicate_Type = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE "compiled_predicate",
+    .tp_basicsize = sizeof(CompiledPredicate),
+    .tp_itemsize = sizeof(Instruction),
+    .tp_dealloc = (destructor)dealloc,
+    .tp_vectorcall_offset = OFFSET_OF_MEMBER(CompiledPredicate, vectorcall),
+    .tp_repr = (reprfunc)repr,
+    .tp_call = PyVectorcall_Call,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_HAVE_VECTORCALL,
+    .tp_doc = "compiled_predicate\n--\n\n"
+               "A predicate tree lowered by compile_predicate() into a flat\n"
+               "instruction array. Call it like the original predicate.",
+    .tp_traverse = (traverseproc)traverse,
+    .tp_clear = (inquiry)clear,
+    .tp_methods = methods,
+    .tp_members = members,
+};
@@ -4,106 +4,121 @@
 #include <signal.h>
 #include <functional>
 
-struct Compose {
-    PyObject_HEAD
-    vectorcallfunc vectorcall;
-    PyObject * functions;
+// The resolved pipeline of a composeN. It is an object of its own so that
+// refresh() can swap it while a call further up the stack, or on another
+// thread, still runs the previous one.
+struct ComposeStages : public PyVarObject {
+    retracesoftware::FastCall stages[];
 };
 
-static PyObject * vectorcall(Compose * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+static ComposeStages * resolve(PyObject * functions) {
+    PyObject * snapshot = PySequence_Tuple(functions);
+    if (!snapshot) return nullptr;
 
-    if (PyTuple_CheckExact(self->functions)) {
-        
-        PyObject * first = PyTuple_GET_ITEM(self->functions, 0);
+    std::vector<PyObject *> stages;
 
-        // PyObject_Print((PyObject *)self, stdout, 0);
-        // printf("\n");
-        // printf("Foo: %p %p\n", self, first);
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(snapshot); i++) {
+        compose_stages(PyTuple_GET_ITEM(snapshot, i), stages);
+    }
 
-        PyObject * result = PyObject_Vectorcall(first, args, nargsf, kwnames);
+    if (stages.empty()) {
+        Py_DECREF(snapshot);
+        PyErr_SetString(PyExc_TypeError, "compose takes at least one function");
+        return nullptr;
+    }
+    fuse_stages(stages);
 
-        if (!result) return nullptr;
+    ComposeStages * self = PyObject_GC_NewVar(ComposeStages, &ComposeStages_Type, stages.size());
 
-        for (Py_ssize_t i = 1; i < PyTuple_GET_SIZE(self->functions); i++) {
+    if (self) {
+        for (size_t i = 0; i < stages.size(); i++) {
+            self->stages[i] = retracesoftware::FastCall(Py_NewRef(stages[i]));
+        }
+        PyObject_GC_Track(self);
+    }
+    Py_DECREF(snapshot);
+    return self;
+}
 
-            PyObject * new_result = PyObject_CallOneArg(PyTuple_GET_ITEM(self->functions, i), result);
+// a finalizer in a collected cycle can still call a composeN whose
+// references tp_clear dropped
+static PyObject * cleared() {
+    PyErr_SetString(PyExc_RuntimeError, "composeN called after it was cleared");
+    return nullptr;
+}
 
-            Py_DECREF(result);
+static inline PyObject * run(ComposeStages * stages, PyObject** args, size_t nargsf, PyObject* kwnames) {
 
-            if (!new_result) {
-                return nullptr;
-            }
-            result = new_result;
-        }
-        return result;
-    } else if (PyList_CheckExact(self->functions)) {
+    PyObject * result = stages->stages[0](args, nargsf, kwnames);
 
-        PyObject * result = PyObject_Vectorcall(PyList_GET_ITEM(self->functions, 0), args, nargsf, kwnames);
+    for (Py_ssize_t i = 1; result && i < Py_SIZE(stages); i++) {
+        PyObject * next = stages->stages[i](result);
+        Py_DECREF(result);
+        result = next;
+    }
+    return result;
+}
 
-        if (!result) return nullptr;
+// built from a fixed sequence: the stages never change, borrowing is enough
+static PyObject * vectorcall(Compose * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    if (!self->stages) return cleared();
 
-        for (Py_ssize_t i = 1; i < PyList_GET_SIZE(self->functions); i++) {
+    return run(self->stages, args, nargsf, kwnames);
+}
 
-            PyObject * new_result = PyObject_CallOneArg(PyList_GET_ITEM(self->functions, i), result);
+// built from a list: refresh() may swap the stages mid-call, so hold them
+static PyObject * vectorcall_refreshable(Compose * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    ComposeStages * stages;
 
-            Py_DECREF(result);
+    Py_BEGIN_CRITICAL_SECTION(self);
+    stages = (ComposeStages *)Py_XNewRef(self->stages);
+    Py_END_CRITICAL_SECTION();
 
-            if (!new_result) {
-                return nullptr;
-            }
-            result = new_result;
-        }
-        return result;
-    } else {
+    if (!stages) return cleared();
 
-        PyObject *iter = PyObject_GetIter(self->functions);
+    PyObject * result = run(stages, args, nargsf, kwnames);
+    Py_DECREF(stages);
 
-        if (!iter) {
-            return NULL;  // Not iterable or error occurred
-        }
+    return result;
+}
 
-        PyObject *item = PyIter_Next(iter);
-
-        if (item) {
-            PyObject * result = PyObject_Vectorcall(item, args, nargsf, kwnames);
-
-            Py_DECREF(item);
-            
-            while ((item = PyIter_Next(iter)) != NULL) {
-                
-                PyObject * new_result = PyObject_CallOneArg(item, result);
-                Py_DECREF(item);
-                Py_DECREF(result);
-
-                if (!new_result) {
-                    Py_DECREF(iter);
-                    return nullptr;
-                }
-                result = new_result;
-            }
-            Py_DECREF(iter);
-
-            if (PyErr_Occurred()) {
-                Py_DECREF(result);
-                return nullptr;
-            }
-            return result;
-        }
+// live mode: the list is read on every call, so mutations show up at once
+static PyObject * vectorcall_live(Compose * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    if (!self->functions) return cleared();
+
+    PyObject * first = list_get_ref(self->functions, 0);
+
+    if (!first) {
+        PyErr_SetString(PyExc_TypeError, "composeN has no functions to call");
         return nullptr;
     }
+    PyObject * result = retracesoftware::FastCall(first)(args, nargsf, kwnames);
+    Py_DECREF(first);
+
+    PyObject * function;
+
+    for (Py_ssize_t i = 1; result && (function = list_get_ref(self->functions, i)); i++) {
+        PyObject * next = retracesoftware::FastCall(function)(result);
+        Py_DECREF(function);
+        Py_DECREF(result);
+        result = next;
+    }
+    return result;
 }
 
 static int traverse(Compose* self, visitproc visit, void* arg) {
     Py_VISIT(self->functions);
+    Py_VISIT(self->stages);
     return 0;
 }
 
 static int clear(Compose* self) {
     Py_CLEAR(self->functions);
+    Py_CLEAR(self->stages);
     return 0;
 }
 
-static void dealloc(Compose *self) {    
+static void dealloc(Compose *self) {
     PyObject_GC_UnTrack(self);          // Untrack from the GC
     clear(self);
     Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
@@ -113,50 +128,100 @@ static PyObject * repr(Compose *self) {
     return PyUnicode_FromFormat(MODULE "Compose%S", self->functions);
 }
 
+static PyObject * refresh(Compose * self, PyObject * unused) {
+    // live, fixed or cleared
+    if (!self->stages || !PyList_Check(self->functions)) Py_RETURN_NONE;
+
+    ComposeStages * stages = resolve(self->functions);
+    if (!stages) return nullptr;
+
+    Py_BEGIN_CRITICAL_SECTION(self);
+    std::swap(self->stages, stages);
+    Py_END_CRITICAL_SECTION();
+
+    Py_DECREF(stages);
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef methods[] = {
+    {"refresh", (PyCFunction)refresh, METH_NOARGS,
+     "refresh()\n--\n\n"
+     "Re-read the function list after it was mutated. Calls already in\n"
+     "progress finish with the previous functions. A no-op in live mode or\n"
+     "when not built from a list."},
+    {NULL}  // Sentinel
+};
+
 static PyMemberDef members[] = {
     {"functions", T_OBJECT, offsetof(Compose, functions), READONLY, "The sequence of functions to compose."},
     {NULL}  /* Sentinel */
 };
 
-static int init(Compose *self, PyObject *args, PyObject *kwds) {
+static PyObject * create(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    int live = 0;
+
+    if (kwds) {
+        static const char *kwlist[] = {"live", NULL};
+        PyObject * empty = PyTuple_New(0);
+        if (!empty) return nullptr;
+
+        int ok = PyArg_ParseTupleAndKeywords(empty, kwds, "|$p", (char **)kwlist, &live);
+        Py_DECREF(empty);
+        if (!ok) return nullptr;
+    }
+
     if (PyTuple_Size(args) == 0) {
         PyErr_SetString(PyExc_TypeError, "compose takes at least one argument");
-        return -1;
-    }
-    if (PyTuple_Size(args) == 1) {
-        self->functions = Py_NewRef(PyTuple_GetItem(args, 0));
-    } else {
-        self->functions = Py_NewRef(args);
+        return nullptr;
     }
+    // a single callable is a one-stage pipeline, any other single argument
+    // the iterable of functions
+    PyObject * functions = args;
 
-    self->vectorcall = (vectorcallfunc)vectorcall;
-    return 0;
-}
-
-// static PyObject * create(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    if (PyTuple_GET_SIZE(args) == 1 && !PyCallable_Check(PyTuple_GET_ITEM(args, 0))) {
+        functions = PyTuple_GET_ITEM(args, 0);
+    }
 
-//     PyObject * functions;
-    
-//     static const char *kwlist[] = {"functions", NULL};
+    if (live && !PyList_Check(functions)) {
+        PyErr_SetString(PyExc_TypeError, "composeN(live=True) takes a single list of functions");
+        return nullptr;
+    }
 
-//     if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", (char **)kwlist, &functions))
-//     {
-//         return NULL; // Return NULL on failure
-//     }
-    
-//     Compose * self = (Compose *)type->tp_alloc(type, 0);
+    Compose * self = (Compose *)type->tp_alloc(type, 0);
+    if (!self) return nullptr;
 
-//     if (!self) {
-//         return NULL;
-//     }
+    if (live) {
+        self->functions = Py_NewRef(functions);
+        self->vectorcall = (vectorcallfunc)vectorcall_live;
+        return (PyObject *)self;
+    }
 
-//     // PyObject_GC_Track(self);
+    self->stages = resolve(functions);
 
-//     self->functions = Py_NewRef(functions);
-//     self->vectorcall = (vectorcallfunc)vectorcall;
+    if (!self->stages) {
+        Py_DECREF(self);
+        return nullptr;
+    }
 
-//     return (PyObject *)self;
-// }
+    if (PyList_Check(functions)) {
+        // kept so the caller can mutate it and refresh()
+        self->functions = Py_NewRef(functions);
+        self->vectorcall = (vectorcallfunc)vectorcall_refreshable;
+    } else {
+        // fixed: expose the flattened stages, which lets compose splice
+        // this pipeline into its own
+        self->functions = PyTuple_New(Py_SIZE(self->stages));
+        if (!self->functions) {
+            Py_DECREF(self);
+            return nullptr;
+        }
+        for (Py_ssize_t i = 0; i < Py_SIZE(self->stages); i++) {
+            PyTuple_SET_ITEM(self->functions, i, Py_NewRef(self->stages->stages[i].callable));
+        }
+        self->vectorcall = (vectorcallfunc)vectorcall;
+    }
+    return (PyObject *)self;
+}
 
 PyTypeObject Compose_Type = {
     .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
@@ -169,13 +234,18 @@ PyTypeObject Compose_Type = {
     .tp_call = PyVectorcall_Call,
     .tp_str = (reprfunc)repr,
     .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_HAVE_VECTORCALL,
-    .tp_doc = "composeN(*functions)\n--\n\n"
+    .tp_doc = "composeN(*functions, live=False)\n--\n\n"
                "Compose multiple functions into a single callable.\n\n"
                "Calls the first function with all arguments, then passes its result\n"
-               "to the second function, and so on. Optimized for tuple and list\n"
-               "containers with fallback to generic iteration.\n\n"
+               "to the second function, and so on.\n\n"
+               "The functions are resolved once, at construction, into an array of\n"
+               "cached vectorcalls: nested compose/composeN pipelines are flattened,\n"
+               "identity stages are dropped and a constantly feeding another constantly\n"
+               "is discarded. A list of functions is snapshotted too; call refresh()\n"
+               "after mutating it, or pass live=True to read the list on every call.\n\n"
                "Args:\n"
-               "    *functions: One or more callables, or an iterable of callables.\n\n"
+               "    *functions: One or more callables, or an iterable of callables.\n"
+               "    live: Read the given list on every call instead of snapshotting it.\n\n"
                "Returns:\n"
                "    A callable that applies the composition: f_n(...(f_2(f_1(*args)))).\n\n"
                "Example:\n"
@@ -184,8 +254,39 @@ PyTypeObject Compose_Type = {
                "    'HELLO'",
     .tp_traverse = (traverseproc)traverse,
     .tp_clear = (inquiry)clear,
-    // .tp_methods = methods,
+    .tp_methods = methods,
     .tp_members = members,
-    .tp_init = (initproc)init,
-    .tp_new = PyType_GenericNew,
+    .tp_new = create,
+};
+
+static int stages_traverse(ComposeStages * self, visitproc visit, void * arg) {
+    for (Py_ssize_t i = 0; i < Py_SIZE(self); i++) {
+        Py_VISIT(self->stages[i].callable);
+    }
+    return 0;
+}
+
+static int stages_clear(ComposeStages * self) {
+    for (Py_ssize_t i = 0; i < Py_SIZE(self); i++) {
+        Py_CLEAR(self->stages[i].callable);
+    }
+    return 0;
+}
+
+static void stages_dealloc(ComposeStages * self) {
+    PyObject_GC_UnTrack(self);
+    stages_clear(self);
+    PyObject_GC_Del(self);
+}
+
+PyTypeObject ComposeStages_Type = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE "composeN_stages",
+    .tp_basicsize = sizeof(ComposeStages),
+    .tp_itemsize = sizeof(retracesoftware::FastCall),
+    .tp_dealloc = (destructor)stages_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_doc = "Resolved stages of a composeN (internal).",
+    .tp_traverse = (traverseproc)stages_traverse,
+    .tp_clear = (inquiry)stages_clear,
 };
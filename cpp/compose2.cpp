@@ -3,76 +3,143 @@
 #include <structmember.h>
 #include <signal.h>
 #include <functional>
+#include <algorithm>
 
-struct Compose2 : public PyObject {
-    retracesoftware::FastCall f;
-    retracesoftware::FastCall g;
+// A flattened pipeline: stages[0] gets the call's arguments and every later
+// stage the previous result. Nested compose/composeN pipelines are spliced
+// in at construction, so a chain built by sequence() is one loop here
+// rather than one vectorcall per nesting level.
+struct Compose2 : public PyVarObject {
     vectorcallfunc vectorcall;
+    retracesoftware::FastCall stages[];
 };
 
-static PyObject * vectorcall(Compose2 * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+void compose_stages(PyObject * function, std::vector<PyObject *> & stages) {
+    if (Py_TYPE(function) == &Compose2_Type) {
+        Compose2 * compose = (Compose2 *)function;
+
+        for (Py_ssize_t i = 0; i < Py_SIZE(compose); i++) {
+            stages.push_back(compose->stages[i].callable);
+        }
+    } else if (Py_TYPE(function) == &Compose_Type && PyTuple_CheckExact(((Compose *)function)->functions)) {
+        PyObject * functions = ((Compose *)function)->functions;
+
+        for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(functions); i++) {
+            compose_stages(PyTuple_GET_ITEM(functions, i), stages);
+        }
+    } else {
+        stages.push_back(function);
+    }
+}
 
-    assert (!PyErr_Occurred());
+void fuse_stages(std::vector<PyObject *> & stages) {
+    // only later stages are called with exactly one argument, the first
+    // stage sees the call's full argument list and stays
+    auto last = std::remove_if(stages.begin() + 1, stages.end(), is_identity);
+    stages.erase(last, stages.end());
+
+    // a constantly feeding another constantly can neither raise nor have
+    // side effects and its result is ignored, so it goes; anything else
+    // feeding a constantly still runs
+    for (size_t i = stages.size(); i-- > 1;) {
+        if (Py_TYPE(stages[i]) == &Constantly_Type && Py_TYPE(stages[i - 1]) == &Constantly_Type) {
+            stages.erase(stages.begin() + (i - 1));
+        }
+    }
+}
 
-    PyObject * g_res = self->g(args, nargsf, kwnames);
+// a finalizer in a collected cycle can still reach a compose whose stages
+// tp_clear dropped; the first stage goes first, so it tells
+static bool cleared(Compose2 * self) {
+    if (self->stages[0].callable) return false;
 
-    assert ((g_res && !PyErr_Occurred()) || (!g_res && PyErr_Occurred()));
+    PyErr_SetString(PyExc_RuntimeError, "compose used after it was cleared");
+    return true;
+}
 
-    if (!g_res) return nullptr;
+static PyObject * vectorcall(Compose2 * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    if (cleared(self)) return nullptr;
 
-    PyObject * f_res = self->f(g_res);
+    PyObject * result = self->stages[0](args, nargsf, kwnames);
 
-    Py_DECREF(g_res);
+    for (Py_ssize_t i = 1; result && i < Py_SIZE(self); i++) {
+        PyObject * next = self->stages[i](result);
+        Py_DECREF(result);
+        result = next;
+    }
 
-    assert ((f_res && !PyErr_Occurred()) || (!f_res && PyErr_Occurred()));
+    assert ((result && !PyErr_Occurred()) || (!result && PyErr_Occurred()));
 
-    return f_res;
+    return result;
 }
 
 static int traverse(Compose2* self, visitproc visit, void* arg) {
-    Py_VISIT(self->f.callable);
-    Py_VISIT(self->g.callable);
+    for (Py_ssize_t i = 0; i < Py_SIZE(self); i++) {
+        Py_VISIT(self->stages[i].callable);
+    }
     return 0;
 }
 
 static int clear(Compose2* self) {
-    Py_CLEAR(self->f.callable);
-    Py_CLEAR(self->g.callable);
+    for (Py_ssize_t i = 0; i < Py_SIZE(self); i++) {
+        Py_CLEAR(self->stages[i].callable);
+    }
     return 0;
 }
 
-static void dealloc(Compose2 *self) {    
+static void dealloc(Compose2 *self) {
     PyObject_GC_UnTrack(self);          // Untrack from the GC
     clear(self);
     Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
 }
 
-static PyObject * repr(Compose2 *self) {
-    return PyUnicode_FromFormat(MODULE "Compose(f = %S, g = %S)", self->f.callable, self->g.callable);
-}
+static PyObject * functions(Compose2 *self, void * closure) {
+    if (cleared(self)) return nullptr;
 
-// static PyMemberDef members[] = {
-//     {"functions", T_OBJECT, offsetof(Compose, functions), READONLY, "TODO"},
-//     {NULL}  /* Sentinel */
-// };
+    PyObject * result = PyTuple_New(Py_SIZE(self));
+    if (!result) return nullptr;
 
-static PyObject * getattro(Compose2 *self, PyObject *name) {
-    PyObject * g_res = PyObject_GetAttr(self->g.callable, name);
+    for (Py_ssize_t i = 0; i < Py_SIZE(self); i++) {
+        PyTuple_SET_ITEM(result, i, Py_NewRef(self->stages[i].callable));
+    }
+    return result;
+}
 
-    if (!g_res) return nullptr;
+static PyObject * repr(Compose2 *self) {
+    PyObject * stages = functions(self, nullptr);
+    if (!stages) return nullptr;
 
-    PyObject * f_res = self->f(g_res);
+    PyObject * result = PyUnicode_FromFormat(MODULE "compose%S", stages);
+    Py_DECREF(stages);
+    return result;
+}
+
+// Attribute access is composed too: the attribute is read from the first
+// stage and fed through the rest. `functions` is the one attribute the
+// pipeline answers itself.
+static PyObject * getattro(Compose2 *self, PyObject *name) {
+    if (PyUnicode_Check(name) && !PyUnicode_CompareWithASCIIString(name, "functions")) {
+        return functions(self, nullptr);
+    }
+    if (cleared(self)) return nullptr;
 
-    Py_DECREF(g_res);
+    PyObject * result = PyObject_GetAttr(self->stages[0].callable, name);
 
-    return f_res;
+    for (Py_ssize_t i = 1; result && i < Py_SIZE(self); i++) {
+        PyObject * next = self->stages[i](result);
+        Py_DECREF(result);
+        result = next;
+    }
+    return result;
 }
 
 static int setattro(Compose2 *self, PyObject *name, PyObject * value) {
-    return PyObject_SetAttr(self->g.callable, name, value);
+    if (cleared(self)) return -1;
+
+    return PyObject_SetAttr(self->stages[0].callable, name, value);
 }
 
-static int init(Compose2 *self, PyObject *args, PyObject *kwds) {
+static PyObject * create(PyTypeObject * type, PyObject *args, PyObject *kwds) {
 
     PyObject * f;
     PyObject * g;
@@ -81,26 +148,33 @@ static int init(Compose2 *self, PyObject *args, PyObject *kwds) {
 
     if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO", (char **)kwlist, &f, &g))
     {
-        return -1; // Return NULL on failure
+        return nullptr; // Return NULL on failure
     }
 
     if (!PyCallable_Check(f)) {
         PyErr_SetString(PyExc_TypeError, "Parameter f must be callable");
-        return -1;
+        return nullptr;
     }
     if (!PyCallable_Check(g)) {
         PyErr_SetString(PyExc_TypeError, "Parameter g must be callable");
-        return -1;
+        return nullptr;
     }
 
-    self->f = retracesoftware::FastCall(f);
-    self->g = retracesoftware::FastCall(g);
-    Py_INCREF(f);
-    Py_INCREF(g);
+    std::vector<PyObject *> stages;
+
+    compose_stages(g, stages);
+    compose_stages(f, stages);
+    fuse_stages(stages);
 
+    Compose2 * self = (Compose2 *)type->tp_alloc(type, stages.size());
+    if (!self) return nullptr;
+
+    for (size_t i = 0; i < stages.size(); i++) {
+        self->stages[i] = retracesoftware::FastCall(Py_NewRef(stages[i]));
+    }
     self->vectorcall = (vectorcallfunc)vectorcall;
 
-    return 0;
+    return (PyObject *)self;
 }
 
 static PyObject* descr_get(PyObject *self, PyObject *obj, PyObject *type) {
@@ -111,7 +185,7 @@ PyTypeObject Compose2_Type = {
     .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
     .tp_name = MODULE "compose",
     .tp_basicsize = sizeof(Compose2),
-    .tp_itemsize = 0,
+    .tp_itemsize = sizeof(retracesoftware::FastCall),
     .tp_dealloc = (destructor)dealloc,
     .tp_vectorcall_offset = OFFSET_OF_MEMBER(Compose2, vectorcall),
     .tp_repr = (reprfunc)repr,
@@ -119,13 +193,16 @@ PyTypeObject Compose2_Type = {
     .tp_str = (reprfunc)repr,
     .tp_getattro = (getattrofunc)getattro,
     .tp_setattro = (setattrofunc)setattro,
-    .tp_flags = Py_TPFLAGS_DEFAULT | 
-                Py_TPFLAGS_HAVE_GC | 
-                Py_TPFLAGS_HAVE_VECTORCALL | 
+    .tp_flags = Py_TPFLAGS_DEFAULT |
+                Py_TPFLAGS_HAVE_GC |
+                Py_TPFLAGS_HAVE_VECTORCALL |
                 Py_TPFLAGS_METHOD_DESCRIPTOR,
     .tp_doc = "compose(f, g)\n--\n\n"
                "Compose two functions: compose(f, g)(x) == f(g(x)).\n\n"
-               "An optimized two-function composition using cached vectorcall.\n"
+               "Nested compose/composeN pipelines are flattened at construction into\n"
+               "a single array of cached vectorcalls, identity stages are dropped and\n"
+               "a constantly feeding another constantly is discarded. The flattened\n"
+               "stages, in call order, are in `functions`.\n"
                "Attribute access is also composed: getattr(compose(f, g), 'x') == f(g.x).\n\n"
                "Args:\n"
                "    f: The outer function to apply to g's result.\n"
@@ -135,12 +212,11 @@ PyTypeObject Compose2_Type = {
                "Example:\n"
                "    >>> c = compose(str.upper, str.strip)\n"
                "    >>> c('  hello  ')\n"
-               "    'HELLO'",
+               "    'HELLO'\n"
+               "    >>> compose(str.upper, c).functions\n"
+               "    (<method 'strip' of 'str' objects>, <method 'upper' of 'str' objects>, <method 'upper' of 'str' objects>)",
     .tp_traverse = (traverseproc)traverse,
     .tp_clear = (inquiry)clear,
-    // .tp_methods = methods,
-    // .tp_members = members,
     .tp_descr_get = descr_get,
-    .tp_init = (initproc)init,
-    .tp_new = PyType_GenericNew,
+    .tp_new = create,
 };
@@ -52,6 +52,20 @@ static void dealloc(DeepWrap *self) {
     Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
 }
 
+// deepwrap allocates a wrapper for every callable a call returns, and most
+// are dropped straight after, so it keeps its own freelist.
+static FREELIST_LOCAL FreeList freelist;
+
+FreeList & deepwrap_freelist() { return freelist; }
+
+static PyObject * alloc(PyTypeObject * type, Py_ssize_t nitems) {
+    return freelist.alloc(type, nitems);
+}
+
+static void release(void * obj) {
+    freelist.release((PyObject *)obj);
+}
+
 static PyObject * repr(DeepWrap *self) {
     return PyUnicode_FromFormat(MODULE "deepwrap(wrapper = %S, target = %S)", self->wrapper.callable, self->target.callable);
 }
@@ -139,5 +153,7 @@ PyTypeObject DeepWrap_Type = {
     // .tp_members = members,
     .tp_descr_get = descr_get,
     .tp_init = (initproc)init,
+    .tp_alloc = alloc,
     .tp_new = PyType_GenericNew,
+    .tp_free = release,
 };
@@ -37,14 +37,79 @@ static PyObject * dispatch_impl(PyObject *self, PyObject *const *args, Py_ssize_
     return dispatch(args + 1, nargs - 1);
 }
 
+static PyObject * compile_predicate_impl(PyObject *self, PyObject * pred) {
+    return compile_predicate(pred);
+}
+
+static PyObject * map_batch_impl(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    if (nargs != 2) {
+        PyErr_Format(PyExc_TypeError, "map_batch() takes exactly 2 arguments (%zd given)", nargs);
+        return nullptr;
+    }
+    return map_batch(args[0], args[1]);
+}
+
+static PyObject * filter_batch_impl(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    if (nargs != 2) {
+        PyErr_Format(PyExc_TypeError, "filter_batch() takes exactly 2 arguments (%zd given)", nargs);
+        return nullptr;
+    }
+    return filter_batch(args[0], args[1]);
+}
+
 static PyObject * firstof_impl(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
     return firstof(args, nargs);
 }
 
+static PyObject * delay_impl(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+    if (nargs < 1) {
+        PyErr_SetString(PyExc_TypeError, "delay() requires at least one argument");
+        return nullptr;
+    }
+    return delay(args[0], args + 1, nargs - 1);
+}
+
+static PyObject * pool_info_impl(PyObject *self, PyObject *unused) {
+    return pool_info();
+}
+
 static PyObject * py_typeof(PyObject *self, PyObject *obj) { return Py_NewRef((PyObject *)Py_TYPE(obj)); }
 
 static PyObject * identity(PyObject *self, PyObject *obj) { return Py_NewRef(obj); }
 
+bool is_identity(PyObject * obj) {
+    return PyCFunction_Check(obj) && PyCFunction_GET_FUNCTION(obj) == (PyCFunction)identity;
+}
+
+unsigned int type_version_tag(PyTypeObject * type) {
+#if PY_VERSION_HEX >= 0x030C0000
+    return PyUnstable_Type_AssignVersionTag(type) ? type->tp_version_tag : 0;
+#else
+    if (!PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG)) {
+        // a method cache lookup assigns the tag as a side effect
+        static PyObject * name = PyUnicode_InternFromString("__version_tag__");
+        if (!name) {
+            PyErr_Clear();
+            return 0;
+        }
+        _PyType_Lookup(type, name);
+    }
+    return PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG) ? type->tp_version_tag : 0;
+#endif
+}
+
+testfunc native_test(PyObject * pred) {
+    PyTypeObject * type = Py_TYPE(pred);
+
+    if (type == &InstanceTest_Type) return instancetest_native(pred);
+    if (type == &TypePredicate_Type) return typepredicate_test;
+    if (type == &NotPredicate_Type) return notpredicate_test;
+    if (type == &AndPredicate_Type) return andpredicate_test;
+    if (type == &OrPredicate_Type) return orpredicate_test;
+    if (type == &CompiledPredicate_Type) return compiledpredicate_test;
+    return nullptr;
+}
+
 static PyObject * py_instanceof(PyObject *self, PyObject * args, PyObject *kwds) { 
     PyTypeObject * cls = nullptr;
     PyTypeObject * andnot = nullptr;
@@ -144,10 +209,81 @@ static PyMethodDef module_methods[] = {
      "dispatch(test1, then1, test2, then2, ..., [otherwise])\n--\n\n"
      "Create a dispatch/case expression with predicate-function pairs.\n\n"
      "See CasePredicate for details."},
+    {"compile_predicate", (PyCFunction)compile_predicate_impl, METH_O,
+     "compile_predicate(pred)\n--\n\n"
+     "Compile a predicate tree into a flat instruction array.\n\n"
+     "and_predicate, or_predicate, not_predicate, isinstanceof, TypePredicate\n"
+     "and constantly nodes are lowered into type checks and jumps, evaluated\n"
+     "by a single loop with no call per level. Any other predicate is kept\n"
+     "as an opaque call.\n\n"
+     "Args:\n"
+     "    pred: The predicate to compile.\n\n"
+     "Returns:\n"
+     "    A predicate equivalent to pred, with a disassemble() method.\n\n"
+     "Example:\n"
+     "    >>> p = compile_predicate(and_predicate(isinstanceof(int), not_predicate(isinstanceof(bool))))\n"
+     "    >>> p(1), p(True)\n"
+     "    (True, False)"},
+    {"map_batch", (PyCFunction)map_batch_impl, METH_FASTCALL,
+     "map_batch(function, seq)\n--\n\n"
+     "Apply a function to every item of a sequence, in C.\n\n"
+     "Equivalent to list(map(function, seq)), but the function's vectorcall\n"
+     "is resolved once and the items are read straight from a tuple (a list\n"
+     "or other iterable is snapshotted first) into a preallocated list.\n\n"
+     "Args:\n"
+     "    function: The callable to apply, called with one argument.\n"
+     "    seq: The items, a tuple, list or any iterable.\n\n"
+     "Returns:\n"
+     "    A list of the results, in order.\n\n"
+     "Example:\n"
+     "    >>> map_batch(compose(abs, operator.neg), [1, -2, 3])\n"
+     "    [1, 2, 3]"},
+    {"filter_batch", (PyCFunction)filter_batch_impl, METH_FASTCALL,
+     "filter_batch(pred, seq)\n--\n\n"
+     "Keep the items of a sequence for which a predicate is true, in C.\n\n"
+     "Equivalent to [x for x in seq if pred(x)]. Predicates from this module\n"
+     "(isinstanceof, and_predicate, compile_predicate, ...) are evaluated\n"
+     "without boxing their result.\n\n"
+     "Args:\n"
+     "    pred: The predicate, called with one argument.\n"
+     "    seq: The items, a tuple, list or any iterable.\n\n"
+     "Returns:\n"
+     "    A list of the items pred accepted, in order.\n\n"
+     "Example:\n"
+     "    >>> filter_batch(isinstanceof(int), [1, 'a', 2.0, 3])\n"
+     "    [1, 3]"},
     {"firstof", (PyCFunction)firstof_impl, METH_FASTCALL, 
      "firstof(*functions)\n--\n\n"
      "Return the first non-None result from a sequence of functions.\n\n"
      "See firstof type for details."},
+    {"delay", (PyCFunction)delay_impl, METH_FASTCALL,
+     "delay(func, *args)\n--\n\n"
+     "Create a lazy value: func(*args), computed on the first call only.\n\n"
+     "Same as lazy(func, *args, once=True). Later calls, whatever their\n"
+     "arguments, return the cached result or raise the cached exception.\n"
+     "The bound arguments are released after evaluation, and concurrent\n"
+     "first calls wait for a single evaluation rather than repeat it.\n\n"
+     "Args:\n"
+     "    func: The callable to evaluate.\n"
+     "    *args: Arguments to evaluate it with.\n\n"
+     "Returns:\n"
+     "    A callable returning the value.\n\n"
+     "Example:\n"
+     "    >>> config = delay(load_config, path)\n"
+     "    >>> config() is config()\n"
+     "    True"},
+    {"pool_info", (PyCFunction)pool_info_impl, METH_NOARGS,
+     "pool_info()\n--\n\n"
+     "Report the freelists recycling short-lived wrapper objects.\n\n"
+     "deepwrap keeps its own freelist; ThreadLocalProxy.swap() contexts,\n"
+     "partial and lazy share a pool of freelists by block size. hits count\n"
+     "allocations served from a freelist, misses those that went to the\n"
+     "allocator, evictions frees that found the freelist full or closed. On\n"
+     "free-threaded builds the freelists, and so the counters, are per\n"
+     "thread and this reports the calling thread's.\n\n"
+     "Returns:\n"
+     "    A dict with 'deepwrap' and 'shared' entries, each shaped like\n"
+     "    memoize's cache_info()."},
     {NULL, NULL, 0, NULL}  // Sentinel
 };
 
@@ -161,6 +297,10 @@ static PyMethodDef module_methods[] = {
 #define _CONCAT(a, b) a##b
 #define CONCAT(a, b) _CONCAT(a, b)
 
+static void module_free(void * module) {
+    pool_close();
+}
+
 // Module definition
 static PyModuleDef moduledef = {
     PyModuleDef_HEAD_INIT,
@@ -171,7 +311,11 @@ static PyModuleDef moduledef = {
     "predicate combinators, and more. All types support Python 3.11+\n"
     "vectorcall for minimal call overhead.",
     0,
-    module_methods
+    module_methods,
+    nullptr,            // m_slots
+    nullptr,            // m_traverse
+    nullptr,            // m_clear
+    module_free
 };
 
 PyObject *ThreadLocalError = NULL;
@@ -186,12 +330,23 @@ PyMODINIT_FUNC CONCAT(PyInit_, MODULE_NAME)(void) {
         return NULL;
     }
 
+#ifdef Py_GIL_DISABLED
+    // see CACHE_SHARDS in functional.h for how the mutable types cope
+    PyUnstable_Module_SetGIL(module, Py_MOD_GIL_NOT_USED);
+#endif
+
     ThreadLocalError = PyErr_NewException(MODULE "ThreadLocalError", PyExc_RuntimeError, NULL);
     if (!ThreadLocalError) return nullptr;
 
+    if (PyModule_AddObjectRef(module, "ThreadLocalError", ThreadLocalError) < 0) return nullptr;
+
     PyTypeObject * hidden_types[] = {
         &FirstOf_Type,
         &InstanceTest_Type,
+        &ComposeStages_Type,
+        &CompiledPredicate_Type,
+        &ThreadLocalSwap_Type,
+        &Placeholder_Type,
         nullptr
     };
 
@@ -199,6 +354,11 @@ PyMODINIT_FUNC CONCAT(PyInit_, MODULE_NAME)(void) {
         PyType_Ready(hidden_types[i]);
     }
 
+    Placeholder = Placeholder_Type.tp_alloc(&Placeholder_Type, 0);
+    if (!Placeholder) return nullptr;
+
+    if (PyModule_AddObjectRef(module, "Placeholder", Placeholder) < 0) return nullptr;
+
     PyType_Spec * specs[] = {
         &Repeatedly_Spec,
         &DropArgs_Spec,
@@ -235,6 +395,9 @@ PyMODINIT_FUNC CONCAT(PyInit_, MODULE_NAME)(void) {
         &WhenPredicate_Type,
         &CasePredicate_Type,
         &Memoize_Type,
+        &MemoizeArgs_Type,
+        &Cache_Type,
+        &ThreadLocalProxy_Type,
 
         &Partial_Type,
         &MethodInvoker_Type,
@@ -246,6 +409,7 @@ PyMODINIT_FUNC CONCAT(PyInit_, MODULE_NAME)(void) {
         &IfThenElse_Type,
         &AnyArgs_Type,
         &Walker_Type,
+        &TypePredWalker_Type,
         &Always_Type,
         &SelfApply_Type,
         &Spread_Type,
@@ -10,6 +10,7 @@
 #endif
 
 #include <signal.h>
+#include <vector>
 
 #include <Python.h>
 
@@ -17,17 +18,23 @@
 
 #define MODULE "retracesoftware.functional."
 
-// Visibility macros for symbol export control
+// Visibility macros for symbol export control, and inlining hints for hot paths
 // With -fvisibility=hidden, only EXPORT_SYMBOL makes symbols visible
 #if defined(__GNUC__) || defined(__clang__)
     #define EXPORT_SYMBOL __attribute__((visibility("default")))
     #define HIDDEN_SYMBOL __attribute__((visibility("hidden")))
+    #define NOINLINE __attribute__((noinline))
+    #define ALWAYS_INLINE inline __attribute__((always_inline))
 #elif defined(_MSC_VER)
     #define EXPORT_SYMBOL __declspec(dllexport)
     #define HIDDEN_SYMBOL
+    #define NOINLINE __declspec(noinline)
+    #define ALWAYS_INLINE __forceinline
 #else
     #define EXPORT_SYMBOL
     #define HIDDEN_SYMBOL
+    #define NOINLINE
+    #define ALWAYS_INLINE inline
 #endif
 
 #define OFFSET_OF_MEMBER(type, member) \
@@ -40,11 +47,13 @@ extern PyType_Spec DropArgs_Spec;
 extern PyTypeObject InstanceTest_Type;
 extern PyTypeObject CallAll_Type;
 extern PyTypeObject Compose_Type;
+extern PyTypeObject ComposeStages_Type;
 extern PyTypeObject SideEffect_Type;
 // extern PyTypeObject Repeatedly_Type;
 extern PyTypeObject NotPredicate_Type;
 extern PyTypeObject AndPredicate_Type;
 extern PyTypeObject OrPredicate_Type;
+extern PyTypeObject CompiledPredicate_Type;
 extern PyTypeObject TypePredicate_Type;
 extern PyTypeObject TransformArgs_Type;
 extern PyTypeObject First_Type;
@@ -52,10 +61,15 @@ extern PyTypeObject Advice_Type;
 extern PyTypeObject WhenPredicate_Type;
 extern PyTypeObject CasePredicate_Type;
 extern PyTypeObject Memoize_Type;
+extern PyTypeObject MemoizeArgs_Type;
+extern PyTypeObject Cache_Type;
+extern PyTypeObject ThreadLocalProxy_Type;
+extern PyTypeObject ThreadLocalSwap_Type;
 extern PyTypeObject ManyPredicate_Type;
 extern PyTypeObject Walker_Type;
 extern PyTypeObject TypePredWalker_Type;
 extern PyTypeObject Partial_Type;
+extern PyTypeObject Placeholder_Type;
 extern PyTypeObject MethodInvoker_Type;
 extern PyTypeObject Intercept_Type;
 extern PyTypeObject Indexer_Type;
@@ -86,22 +100,292 @@ PyObject * instance_test(PyTypeObject * cls);
 PyObject * notinstance_test(PyTypeObject * cls);
 PyObject * instanceof(PyTypeObject * cls);
 
+// shared so dispatch can see through it, see type_test
+struct TypePredicate {
+    PyObject_HEAD
+    PyTypeObject * cls;
+    vectorcallfunc vectorcall;
+};
+
+// What `test` returns for any instance of `type`, for predicates that only
+// look at the argument's type (isinstanceof, TypePredicate): 1 or 0. Any
+// other predicate gives -1. Never calls into Python.
+int type_test(PyObject * test, PyTypeObject * type);
+
+// Native predicate protocol. Predicates implemented in this module evaluate
+// straight to 1/0, or -1 with an exception set, with no bool object in
+// between and no PyObject_IsTrue. Combinators hold their tests as
+// Predicate, which picks up the native entry point at construction and
+// falls back to a vectorcall plus truth test for anything else.
+typedef int (*testfunc)(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames);
+
+// The native entry point for `pred`, or nullptr.
+testfunc native_test(PyObject * pred);
+
+testfunc instancetest_native(PyObject * pred);
+int typepredicate_test(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames);
+int notpredicate_test(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames);
+int andpredicate_test(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames);
+int orpredicate_test(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames);
+int compiledpredicate_test(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames);
+
+// The types tested by a bool isinstanceof predicate; false for the
+// instance_test/notinstance_test variants.
+bool instancetest_types(PyObject * pred, PyTypeObject ** type, PyTypeObject ** andnot);
+
+PyObject * compile_predicate(PyObject * pred);
+
+PyObject * map_batch(PyObject * function, PyObject * seq);
+PyObject * filter_batch(PyObject * pred, PyObject * seq);
+
+// Truth of a call result, consuming the reference; -1 if result is null.
+inline int truth(PyObject * result) {
+    if (!result) return -1;
+
+    int status = result == Py_True ? 1 : result == Py_False ? 0 : PyObject_IsTrue(result);
+    Py_DECREF(result);
+    return status;
+}
+
+struct Predicate {
+    testfunc test = nullptr;
+    retracesoftware::FastCall call;
+
+    Predicate() {}
+    Predicate(PyObject * callable) : test(native_test(callable)), call(callable) {}
+
+    int operator()(PyObject * const * args, size_t nargsf, PyObject * kwnames) const {
+        return test ? test(call.callable, args, nargsf, kwnames)
+                    : truth(call((PyObject **)args, nargsf, kwnames));
+    }
+};
+
 extern PyObject * ThreadLocalError;
 
 PyObject * join(const char * sep, PyObject * elements);
 
 // PyObject * find_first(std::function<PyObject * (PyObject *)> f, PyObject * obj);
 
+// Singleton marking a partial argument to be filled from the call
+extern PyObject * Placeholder;
+
 PyObject * partial(PyObject * function, PyObject * const * args, size_t nargs);
+PyObject * delay(PyObject * function, PyObject * const * args, size_t nargs);
 PyObject * dispatch(PyObject * const * args, size_t nargs);
 PyObject * firstof(PyObject * const * args, size_t nargs);
 
+// composeN; shared so compose can splice tuple-backed instances
+struct ComposeStages;
+
+struct Compose {
+    PyObject_HEAD
+    vectorcallfunc vectorcall;
+    PyObject * functions;
+    ComposeStages * stages;     // nullptr in live mode
+};
+
+bool is_identity(PyObject * obj);
+
+// The type's version tag, assigning one if needed; 0 when it can't have
+// one. It changes whenever the type or anything in its MRO is modified,
+// which makes it the key check for per-type caches.
+unsigned int type_version_tag(PyTypeObject * type);
+
+// Appends the call-order stages of `function` to `stages` (borrowed),
+// splicing in nested compose and tuple-backed composeN pipelines.
+void compose_stages(PyObject * function, std::vector<PyObject *> & stages);
+
+// Drops identity stages after the first, and any constantly feeding another
+// constantly; stages with possible side effects are always kept.
+void fuse_stages(std::vector<PyObject *> & stages);
+
+struct AdaptiveOrder;
+
 struct ManyPredicate : public PyObject {
     PyObject * elements;
     vectorcallfunc vectorcall;
     PyObject *weakreflist;
+    // resolved from the elements tuple, whose references they borrow
+    Predicate * predicates;
+    Py_ssize_t npredicates;
+    AdaptiveOrder * adaptive;   // nullptr unless created with adaptive=True
+};
+
+// Resolves self->elements, which must be a tuple, into self->predicates and
+// applies the and/or_predicate keyword arguments.
+int many_predicate_init(ManyPredicate * self, PyObject * kwds);
+
+// Evaluates an adaptive and/or_predicate; short_on is the child result that
+// decides the outcome (0 for and, 1 for or).
+int many_predicate_adaptive(ManyPredicate * self, PyObject * const * args, size_t nargsf, PyObject * kwnames, int short_on);
+
+// Per-instance counters for the caching types. Build with -DCACHE_STATS=0 to
+// compile the counting out of the hot paths; cache_info() then reports only
+// the size fields.
+#ifndef CACHE_STATS
+#define CACHE_STATS 1
+#endif
+
+struct CacheStats {
+#if CACHE_STATS
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t weakref_evictions = 0;
+
+    void hit() { hits++; }
+    void miss() { misses++; }
+    void evict() { evictions++; }
+    void weakref_evict() { weakref_evictions++; }
+#else
+    void hit() {}
+    void miss() {}
+    void evict() {}
+    void weakref_evict() {}
+#endif
+
+    CacheStats & operator+=(CacheStats const & other) {
+#if CACHE_STATS
+        hits += other.hits;
+        misses += other.misses;
+        evictions += other.evictions;
+        weakref_evictions += other.weakref_evictions;
+#endif
+        return *this;
+    }
 };
 
+// Free-threaded builds (Py_GIL_DISABLED) run the module without the GIL.
+// Everything but the caching types is immutable after construction; those
+// split their tables into CACHE_SHARDS shards, each behind its own lock, so
+// concurrent lookups only contend within a shard. With the GIL there is a
+// single shard and the lock compiles away.
+//
+// A ShardLock must never be held across a call back into Python, including
+// a decref, as that may re-enter the cache or wait on the GC.
+#ifdef Py_GIL_DISABLED
+#define CACHE_SHARDS 16
+
+struct ShardLock {
+    PyMutex mutex = {0};
+
+    void lock() { PyMutex_Lock(&mutex); }
+    void unlock() { PyMutex_Unlock(&mutex); }
+};
+#else
+#define CACHE_SHARDS 1
+
+struct ShardLock {
+    void lock() {}
+    void unlock() {}
+};
+#endif
+
+// Picks a shard from the middle of the hash: unordered_dense takes bucket
+// indices from the high bits and fingerprints from the low byte.
+inline size_t shard_index(uint64_t hash, size_t nshards) {
+    return nshards == 1 ? 0 : (size_t)((hash >> 32) % nshards);
+}
+
+// New reference to list[i], or nullptr if i is out of range (no error set).
+inline PyObject * list_get_ref(PyObject * list, Py_ssize_t i) {
+#if PY_VERSION_HEX >= 0x030D0000
+    PyObject * item = PyList_GetItemRef(list, i);
+    if (!item) PyErr_Clear();
+    return item;
+#else
+    return i < PyList_GET_SIZE(list) ? Py_NewRef(PyList_GET_ITEM(list, i)) : nullptr;
+#endif
+}
+
+// The raised exception as one object, clearing it, and the reverse
+// (stealing the reference): the 3.12 API on every version.
+inline PyObject * fetch_error() {
+#if PY_VERSION_HEX >= 0x030C0000
+    return PyErr_GetRaisedException();
+#else
+    PyObject *type, *value, *traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+    PyErr_NormalizeException(&type, &value, &traceback);
+    if (traceback) PyException_SetTraceback(value, traceback);
+    Py_XDECREF(type);
+    Py_XDECREF(traceback);
+    return value;
+#endif
+}
+
+inline void restore_error(PyObject * error) {
+#if PY_VERSION_HEX >= 0x030C0000
+    PyErr_SetRaisedException(error);
+#else
+    PyErr_Restore(Py_NewRef(Py_TYPE(error)), error, PyException_GetTraceback(error));
+#endif
+}
+
+// Per-object critical sections arrived in 3.13; before that the GIL is
+// the only lock there is.
+#ifndef Py_BEGIN_CRITICAL_SECTION
+#define Py_BEGIN_CRITICAL_SECTION(op) {
+#define Py_END_CRITICAL_SECTION() }
+#endif
+
+// Approximate heap held by an unordered_dense map: the value vector plus the
+// bucket array.
+template<typename Map>
+inline size_t map_bytes(Map const & map) {
+    return map.values().capacity() * sizeof(typename Map::value_type) +
+           map.bucket_count() * sizeof(typename Map::bucket_type);
+}
+
+PyObject * cache_info(CacheStats const & stats, size_t size, Py_ssize_t maxsize, size_t bytes);
+
+// Freelists for short-lived GC objects, installed as a static type's
+// tp_alloc/tp_free. A FreeList keeps the memory of up to `capacity` dead
+// objects of one block size and hands it back, zeroed and tracked as
+// PyType_GenericAlloc would, to the next allocation. Heap subclasses get the
+// generic slots from type_new and never come through here.
+//
+// With the GIL the lists are global; free-threaded builds keep one set per
+// thread, so neither side needs a lock. Blocks are only ever freed while a
+// thread state is attached: a thread's lists are drained as its thread
+// state is cleared, the global ones when the module is freed, see
+// pool_close().
+#ifdef Py_GIL_DISABLED
+#define FREELIST_LOCAL thread_local
+#else
+#define FREELIST_LOCAL
+#endif
+
+struct FreeList {
+    static constexpr int capacity = 64;
+
+    PyObject * items[capacity];
+    int size = 0;
+    CacheStats stats;   // hits reuse a block, misses allocate, evictions free one the list had no room for
+
+    PyObject * alloc(PyTypeObject * type, Py_ssize_t nitems);
+    void release(PyObject * obj);
+    void drain();
+};
+
+// Bytes PyType_GenericAlloc gives an instance of type with nitems items.
+size_t alloc_size(PyTypeObject * type, Py_ssize_t nitems);
+
+// tp_alloc/tp_free for the shared pool: one FreeList per block size up to
+// 256 bytes, so small wrappers of different types recycle each other's
+// memory.
+PyObject * pool_alloc(PyTypeObject * type, Py_ssize_t nitems);
+void pool_free(void * obj);
+
+// The calling thread's deepwrap freelist, for pool_info().
+FreeList & deepwrap_freelist();
+
+PyObject * pool_info();
+
+// Frees the blocks held by the calling thread's freelists (all of them with
+// the GIL) and sends later frees straight to the allocator.
+void pool_close();
+
 inline int check_callable(PyObject *obj, void *out) {
     if (!PyCallable_Check(obj)) {
         PyErr_Format(PyExc_TypeError, "Expected a callable object, but recieved: %S", obj);
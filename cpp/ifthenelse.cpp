@@ -4,7 +4,7 @@
 struct IfThenElse {
     PyObject_HEAD
     int from_arg;
-    retracesoftware::FastCall test;
+    Predicate test;
     retracesoftware::FastCall then;
     retracesoftware::FastCall otherwise;
     vectorcallfunc vectorcall;
@@ -14,11 +14,7 @@ static PyObject * vectorcall(IfThenElse * self, PyObject** args, size_t nargsf,
     
     assert (!PyErr_Occurred());
 
-    PyObject * test_res = self->test(args + self->from_arg, PyVectorcall_NARGS(nargsf) - self->from_arg, kwnames);
-
-    if (!test_res) return nullptr;
-    int is_true = PyObject_IsTrue(test_res);
-    Py_DECREF(test_res);
+    int is_true = self->test(args + self->from_arg, PyVectorcall_NARGS(nargsf) - self->from_arg, kwnames);
 
     int nargs = PyVectorcall_NARGS(nargsf);
 
@@ -37,7 +33,7 @@ static PyObject * vectorcall(IfThenElse * self, PyObject** args, size_t nargsf,
 }
 
 static int traverse(IfThenElse* self, visitproc visit, void* arg) {
-    Py_VISIT(self->test.callable);
+    Py_VISIT(self->test.call.callable);
     Py_VISIT(self->then.callable);
     Py_VISIT(self->otherwise.callable);
 
@@ -45,7 +41,7 @@ static int traverse(IfThenElse* self, visitproc visit, void* arg) {
 }
 
 static int clear(IfThenElse* self) {
-    Py_CLEAR(self->test.callable);
+    Py_CLEAR(self->test.call.callable);
     Py_CLEAR(self->then.callable);
     Py_CLEAR(self->otherwise.callable);
     return 0;
@@ -85,7 +81,7 @@ static int init(IfThenElse *self, PyObject *args, PyObject *kwds) {
     CHECK_CALLABLE(then);
     CHECK_CALLABLE(otherwise);
     
-    self->test = retracesoftware::FastCall(test);
+    self->test = Predicate(test);
     Py_INCREF(test);
 
     if (then) {
@@ -24,20 +24,30 @@ struct InstanceTest : public PyObject {
         Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
     }
 
-    static PyObject * instanceof_andnot(InstanceTest * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    static int test_andnot(InstanceTest * self, PyObject * const * args, size_t nargsf, PyObject* kwnames) {
         if (PyVectorcall_NARGS(nargsf) != 1 || kwnames) {
             PyErr_SetString(PyExc_TypeError, "instanceof takes one positional argument");
-            return nullptr;
+            return -1;
         }
-        return PyBool_FromLong(PyObject_TypeCheck(args[0], self->type) && (!self->andnot || PyObject_TypeCheck(args[0], self->andnot)));
+        return PyObject_TypeCheck(args[0], self->type) && (!self->andnot || PyObject_TypeCheck(args[0], self->andnot));
     }
 
-    static PyObject * instanceof(InstanceTest * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    static int test(InstanceTest * self, PyObject * const * args, size_t nargsf, PyObject* kwnames) {
         if (PyVectorcall_NARGS(nargsf) != 1 || kwnames) {
             PyErr_SetString(PyExc_TypeError, "instanceof takes one positional argument");
-            return nullptr;
+            return -1;
         }
-        return PyBool_FromLong(PyObject_TypeCheck(args[0], self->type));
+        return PyObject_TypeCheck(args[0], self->type);
+    }
+
+    static PyObject * instanceof_andnot(InstanceTest * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+        int status = test_andnot(self, args, nargsf, kwnames);
+        return status < 0 ? nullptr : PyBool_FromLong(status);
+    }
+
+    static PyObject * instanceof(InstanceTest * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+        int status = test(self, args, nargsf, kwnames);
+        return status < 0 ? nullptr : PyBool_FromLong(status);
     }
 
     static PyObject * instancetest(InstanceTest * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
@@ -116,3 +126,40 @@ PyObject * notinstance_test(PyTypeObject * cls) {
     return create(cls, nullptr, (vectorcallfunc)InstanceTest::notinstancetest);
 }
 
+
+int type_test(PyObject * test, PyTypeObject * type) {
+    if (Py_TYPE(test) == &TypePredicate_Type) {
+        return type == ((TypePredicate *)test)->cls;
+    }
+    if (Py_TYPE(test) == &InstanceTest_Type) {
+        InstanceTest * self = (InstanceTest *)test;
+
+        if (self->vectorcall == (vectorcallfunc)InstanceTest::instanceof) {
+            return PyType_IsSubtype(type, self->type);
+        }
+        if (self->vectorcall == (vectorcallfunc)InstanceTest::instanceof_andnot) {
+            return PyType_IsSubtype(type, self->type) && (!self->andnot || PyType_IsSubtype(type, self->andnot));
+        }
+        // instance_test/notinstance_test return the argument itself, whose
+        // truth is not the type's
+    }
+    return -1;
+}
+
+testfunc instancetest_native(PyObject * pred) {
+    vectorcallfunc vectorcall = ((InstanceTest *)pred)->vectorcall;
+
+    if (vectorcall == (vectorcallfunc)InstanceTest::instanceof) return (testfunc)InstanceTest::test;
+    if (vectorcall == (vectorcallfunc)InstanceTest::instanceof_andnot) return (testfunc)InstanceTest::test_andnot;
+    return nullptr;
+}
+
+bool instancetest_types(PyObject * pred, PyTypeObject ** type, PyTypeObject ** andnot) {
+    InstanceTest * self = (InstanceTest *)pred;
+
+    if (!instancetest_native(pred)) return false;
+
+    *type = self->type;
+    *andnot = self->vectorcall == (vectorcallfunc)InstanceTest::instanceof_andnot ? self->andnot : nullptr;
+    return true;
+}
@@ -1,4 +1,18 @@
 #include "functional.h"
+#include <atomic>
+#include <mutex>
+
+// The evaluation state of a once=True lazy. The first caller takes the lock
+// and runs the function; concurrent first callers wait on it with their
+// thread state released, and every later call only reads `done`.
+struct Once {
+    std::atomic<bool> done {false};
+    std::atomic<unsigned long> owner {0};   // thread evaluating, to catch re-entry
+    std::mutex lock;
+    PyObject * result = nullptr;            // the value, or the exception raised
+    PyObject * traceback = nullptr;         // the exception's own traceback, restored on every raise
+    bool failed = false;
+};
 
 struct Lazy : public PyVarObject {
     vectorcallfunc vectorcall;
@@ -7,13 +21,18 @@ struct Lazy : public PyVarObject {
     retracesoftware::FastCall function;
     // PyObject * function;        
     // vectorcallfunc function_vectorcall;
-    PyObject * args[];
+    Once * once;        // nullptr unless created with once=True
+    PyObject * args[];  // emptied once a once=True lazy has been evaluated
 
     static int clear(Lazy* self) {
         Py_CLEAR(self->function.callable);
         for (int i = 0; i < self->ob_size; i++) {
             Py_CLEAR(self->args[i]);
         }
+        if (self->once) {
+            Py_CLEAR(self->once->result);
+            Py_CLEAR(self->once->traceback);
+        }
         return 0;
     }
     
@@ -22,6 +41,10 @@ struct Lazy : public PyVarObject {
         for (int i = 0; i < self->ob_size; i++) {
             Py_VISIT(self->args[i]);
         }
+        if (self->once && self->once->done.load(std::memory_order_acquire)) {
+            Py_VISIT(self->once->result);
+            Py_VISIT(self->once->traceback);
+        }
         return 0;
     }
     
@@ -30,6 +53,7 @@ struct Lazy : public PyVarObject {
         PyObject_GC_UnTrack(self);          // Untrack from the GC
 
         clear(self);
+        delete self->once;
         Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
     }
 
@@ -41,12 +65,80 @@ struct Lazy : public PyVarObject {
         return self->function(self->args, self->ob_size, nullptr);
     }
 
+    // Runs the function under once->lock, publishes the outcome and drops
+    // the arguments, which are never needed again.
+    static void evaluate(Lazy * self) {
+        Once * once = self->once;
+
+        once->owner.store(PyThread_get_thread_ident(), std::memory_order_relaxed);
+        PyObject * result = self->function(self->args, self->ob_size, nullptr);
+        once->owner.store(0, std::memory_order_relaxed);
+
+        once->failed = !result;
+        once->result = result ? result : fetch_error();
+        if (once->failed) once->traceback = PyException_GetTraceback(once->result);
+        once->done.store(true, std::memory_order_release);
+
+        PyObject ** dropped = (PyObject **)alloca(sizeof(PyObject *) * (self->ob_size + 1));
+
+        Py_BEGIN_CRITICAL_SECTION(self);
+        for (Py_ssize_t i = 0; i < self->ob_size; i++) {
+            dropped[i] = self->args[i];
+            self->args[i] = nullptr;
+        }
+        Py_END_CRITICAL_SECTION();
+
+        for (Py_ssize_t i = 0; i < self->ob_size; i++) {
+            Py_XDECREF(dropped[i]);
+        }
+    }
+
+    static PyObject * call_once(Lazy * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+        Once * once = self->once;
+
+        if (!once->done.load(std::memory_order_acquire)) {
+            if (once->owner.load(std::memory_order_relaxed) == PyThread_get_thread_ident()) {
+                PyErr_SetString(PyExc_RuntimeError, "lazy value depends on itself");
+                return nullptr;
+            }
+            if (!once->lock.try_lock()) {
+                Py_BEGIN_ALLOW_THREADS
+                once->lock.lock();
+                Py_END_ALLOW_THREADS
+            }
+            if (!once->done.load(std::memory_order_relaxed)) evaluate(self);
+            once->lock.unlock();
+        }
+
+        if (!once->result) {
+            // only after tp_clear broke a cycle through the result
+            PyErr_SetString(PyExc_RuntimeError, "lazy value was cleared");
+            return nullptr;
+        }
+        if (once->failed) {
+            // each raise prepends the frames it passes through, start over
+            // from the original so the traceback doesn't grow with every call
+            PyException_SetTraceback(once->result, once->traceback ? once->traceback : Py_None);
+            restore_error(Py_NewRef(once->result));
+            return nullptr;
+        }
+        return Py_NewRef(once->result);
+    }
+
     static PyObject* create(PyTypeObject* type, PyObject* args, PyObject* kwds) {
         if (PyTuple_Size(args) == 0) {
             PyErr_SetString(PyExc_TypeError, "lazy requires at least one positional argument");
             return nullptr;
         }
 
+        int once = 0;
+
+        if (kwds) {
+            PyObject * obj = PyDict_GetItemString(kwds, "once");
+
+            if (obj && (once = PyObject_IsTrue(obj)) < 0) return nullptr;
+        }
+
         Lazy* self = (Lazy *)Lazy_Type.tp_alloc(type, PyTuple_Size(args) - 1);
         
         // Check if the allocation was successful
@@ -60,8 +152,9 @@ struct Lazy : public PyVarObject {
             self->args[i] = Py_NewRef(PyTuple_GetItem(args, i + 1));
         }
 
-        self->vectorcall = (vectorcallfunc)Lazy::call;
+        self->vectorcall = once ? (vectorcallfunc)Lazy::call_once : (vectorcallfunc)Lazy::call;
         self->dict = NULL;
+        self->once = once ? new Once() : nullptr;
 
         return (PyObject*)self;
     }
@@ -78,7 +171,17 @@ static PyObject * repr(Lazy *self) {
     if (!result) return nullptr;
 
     for (Py_ssize_t i = 0; i < Py_SIZE(self); ++i) {
-        PyObject *item_repr = PyUnicode_FromFormat(", %S", self->args[i]);
+        // a once=True lazy may be dropping its arguments concurrently
+        PyObject * arg;
+
+        Py_BEGIN_CRITICAL_SECTION(self);
+        arg = Py_XNewRef(self->args[i]);
+        Py_END_CRITICAL_SECTION();
+
+        if (!arg) continue;
+
+        PyObject *item_repr = PyUnicode_FromFormat(", %S", arg);
+        Py_DECREF(arg);
 
         if (item_repr == NULL) {
             Py_DECREF(result);
@@ -116,13 +219,18 @@ PyTypeObject Lazy_Type = {
                 Py_TPFLAGS_HAVE_VECTORCALL | 
                 Py_TPFLAGS_METHOD_DESCRIPTOR |
                 Py_TPFLAGS_BASETYPE,
-    .tp_doc = "lazy(func, *args)\n--\n\n"
+    .tp_doc = "lazy(func, *args, once=False)\n--\n\n"
                "Defer a function call until invoked.\n\n"
                "Creates a callable that, when called (with any arguments, ignored),\n"
                "invokes func(*args). Similar to partial with required=0.\n\n"
+               "With once=True the call happens only on the first invocation: its\n"
+               "result is kept, or the exception it raised is raised again, on\n"
+               "every later one, and the arguments are released. Concurrent first\n"
+               "callers wait for a single evaluation.\n\n"
                "Args:\n"
                "    func: The callable to defer.\n"
-               "    *args: Arguments to pass when invoked.\n\n"
+               "    *args: Arguments to pass when invoked.\n"
+               "    once: Evaluate at most once and cache the outcome.\n\n"
                "Returns:\n"
                "    A callable that executes func(*args) when called.\n\n"
                "Example:\n"
@@ -135,7 +243,9 @@ PyTypeObject Lazy_Type = {
 
     // .tp_methods = methods,
     // .tp_members = members,
+    .tp_alloc = pool_alloc,
     .tp_new = (newfunc)Lazy::create,
+    .tp_free = pool_free,
     // .tp_new = PyType_GenericNew,
 };
 
@@ -158,3 +268,17 @@ PyObject * lazy(PyObject * function, PyObject * const * args, size_t nargs) {
     return (PyObject *)self;
 }
 
+PyObject * delay(PyObject * function, PyObject * const * args, size_t nargs) {
+    if (!PyCallable_Check(function)) {
+        PyErr_Format(PyExc_TypeError, "delay() expects a callable, got %R", function);
+        return nullptr;
+    }
+
+    Lazy * self = (Lazy *)lazy(function, args, nargs);
+    if (!self) return nullptr;
+
+    self->once = new Once();
+    self->vectorcall = (vectorcallfunc)Lazy::call_once;
+    return (PyObject *)self;
+}
+
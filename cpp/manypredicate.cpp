@@ -1,5 +1,12 @@
 #include "functional.h"
 #include <structmember.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 static int traverse(ManyPredicate* self, visitproc visit, void* arg) {
     Py_VISIT(self->elements);
@@ -12,9 +19,242 @@ static int clear(ManyPredicate* self) {
     return 0;
 }
 
+// Adaptive and/or_predicate. One call in SAMPLE_EVERY is timed, recording
+// for each child how often it ran, how often it decided the outcome and
+// how many cycles it took. Every REORDER_EVERY samples the children are
+// sorted by cycles per decisive result, the order that minimises expected
+// cost for independent tests, and the counters halved so the order keeps
+// tracking the workload. Children that never ran yet go first, to get
+// measured.
+//
+// The order is a word of 4-bit child indices, read once per call, so a
+// reorder on another thread or in a nested call never disturbs a running
+// evaluation.
+#define ADAPTIVE_MAX 16
+#define SAMPLE_EVERY 16
+#define REORDER_EVERY 64
+
+static inline uint64_t cycle_count() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+struct AdaptiveOrder {
+    struct Counters {
+        std::atomic<uint64_t> evals {0};
+        std::atomic<uint64_t> decided {0};
+        std::atomic<uint64_t> cycles {0};
+    };
+
+    std::atomic<uint64_t> order;
+    std::atomic<uint64_t> calls {0};
+    std::atomic<uint64_t> reorders {0};
+    std::atomic_flag busy = ATOMIC_FLAG_INIT;
+    Counters counters[ADAPTIVE_MAX];
+
+    AdaptiveOrder(Py_ssize_t n) {
+        uint64_t initial = 0;
+        for (Py_ssize_t i = 0; i < n; i++) initial |= (uint64_t)i << (4 * i);
+        order.store(initial, std::memory_order_relaxed);
+    }
+
+    static Py_ssize_t at(uint64_t order, Py_ssize_t slot) { return (order >> (4 * slot)) & 0xF; }
+
+    void reorder(Py_ssize_t n) {
+        if (busy.test_and_set(std::memory_order_acquire)) return;
+
+        uint64_t current = order.load(std::memory_order_relaxed);
+        Py_ssize_t slots[ADAPTIVE_MAX];
+        double keys[ADAPTIVE_MAX];
+
+        for (Py_ssize_t i = 0; i < n; i++) {
+            slots[i] = at(current, i);
+
+            Counters & c = counters[slots[i]];
+            uint64_t evals = c.evals.load(std::memory_order_relaxed);
+            uint64_t decided = c.decided.load(std::memory_order_relaxed);
+
+            keys[slots[i]] = evals == 0 ? -1.0
+                           : decided == 0 ? HUGE_VAL
+                           : (double)c.cycles.load(std::memory_order_relaxed) / decided;
+        }
+        std::stable_sort(slots, slots + n, [&keys](Py_ssize_t a, Py_ssize_t b) { return keys[a] < keys[b]; });
+
+        uint64_t next = 0;
+        for (Py_ssize_t i = 0; i < n; i++) next |= (uint64_t)slots[i] << (4 * i);
+        order.store(next, std::memory_order_relaxed);
+
+        for (Py_ssize_t i = 0; i < n; i++) {
+            Counters & c = counters[i];
+            c.evals.store(c.evals.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+            c.decided.store(c.decided.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+            c.cycles.store(c.cycles.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+        }
+        reorders.fetch_add(1, std::memory_order_relaxed);
+        busy.clear(std::memory_order_release);
+    }
+};
+
+int many_predicate_adaptive(ManyPredicate * self, PyObject * const * args, size_t nargsf, PyObject * kwnames, int short_on) {
+    AdaptiveOrder * adaptive = self->adaptive;
+    uint64_t order = adaptive->order.load(std::memory_order_relaxed);
+
+    // a lost increment between threads only shifts the sampling
+    uint64_t call = adaptive->calls.load(std::memory_order_relaxed) + 1;
+    adaptive->calls.store(call, std::memory_order_relaxed);
+
+    if (call % SAMPLE_EVERY) {
+        for (Py_ssize_t i = 0; i < self->npredicates; i++) {
+            int status = self->predicates[AdaptiveOrder::at(order, i)](args, nargsf, kwnames);
+
+            if (status != !short_on) return status;
+        }
+        return !short_on;
+    }
+
+    int result = !short_on;
+
+    for (Py_ssize_t i = 0; i < self->npredicates; i++) {
+        Py_ssize_t index = AdaptiveOrder::at(order, i);
+        uint64_t start = cycle_count();
+
+        int status = self->predicates[index](args, nargsf, kwnames);
+
+        if (status < 0) return -1;
+
+        AdaptiveOrder::Counters & c = adaptive->counters[index];
+        c.evals.fetch_add(1, std::memory_order_relaxed);
+        c.cycles.fetch_add(cycle_count() - start, std::memory_order_relaxed);
+
+        if (status == short_on) {
+            c.decided.fetch_add(1, std::memory_order_relaxed);
+            result = short_on;
+            break;
+        }
+    }
+    if (call % (SAMPLE_EVERY * REORDER_EVERY) == 0) {
+        adaptive->reorder(self->npredicates);
+    }
+    return result;
+}
+
+int many_predicate_init(ManyPredicate * self, PyObject * kwds) {
+    int adaptive = 0;
+
+    if (kwds) {
+        static const char *kwlist[] = {"adaptive", NULL};
+        PyObject * empty = PyTuple_New(0);
+        if (!empty) return -1;
+
+        int ok = PyArg_ParseTupleAndKeywords(empty, kwds, "|$p", (char **)kwlist, &adaptive);
+        Py_DECREF(empty);
+        if (!ok) return -1;
+    }
+
+    Py_ssize_t n = PyTuple_GET_SIZE(self->elements);
+
+    if (adaptive && n > ADAPTIVE_MAX) {
+        PyErr_Format(PyExc_ValueError, "adaptive %s takes at most %d predicates", Py_TYPE(self)->tp_name, ADAPTIVE_MAX);
+        return -1;
+    }
+
+    self->predicates = PyMem_New(Predicate, n ? n : 1);
+    if (!self->predicates) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        new (self->predicates + i) Predicate(PyTuple_GET_ITEM(self->elements, i));
+    }
+    self->npredicates = n;
+
+    if (adaptive) self->adaptive = new AdaptiveOrder(n);
+    return 0;
+}
+
+// Predicates in evaluation order.
+static PyObject * order(ManyPredicate * self, void * closure) {
+    if (!self->adaptive) return Py_NewRef(self->elements);
+
+    uint64_t current = self->adaptive->order.load(std::memory_order_relaxed);
+    PyObject * result = PyTuple_New(self->npredicates);
+    if (!result) return nullptr;
+
+    for (Py_ssize_t i = 0; i < self->npredicates; i++) {
+        PyTuple_SET_ITEM(result, i, Py_NewRef(PyTuple_GET_ITEM(self->elements, AdaptiveOrder::at(current, i))));
+    }
+    return result;
+}
+
+static PyObject * adaptive_info(ManyPredicate * self, PyObject * unused) {
+    if (!self->adaptive) Py_RETURN_NONE;
+
+    AdaptiveOrder * adaptive = self->adaptive;
+    uint64_t current = adaptive->order.load(std::memory_order_relaxed);
+
+    PyObject * predicates = PyList_New(self->npredicates);
+    if (!predicates) return nullptr;
+
+    for (Py_ssize_t i = 0; i < self->npredicates; i++) {
+        Py_ssize_t index = AdaptiveOrder::at(current, i);
+        AdaptiveOrder::Counters & c = adaptive->counters[index];
+
+        PyObject * entry = Py_BuildValue("{s:O,s:K,s:K,s:K}",
+            "predicate", PyTuple_GET_ITEM(self->elements, index),
+            "evals", (unsigned long long)c.evals.load(std::memory_order_relaxed),
+            "decided", (unsigned long long)c.decided.load(std::memory_order_relaxed),
+            "cycles", (unsigned long long)c.cycles.load(std::memory_order_relaxed));
+
+        if (!entry) {
+            Py_DECREF(predicates);
+            return nullptr;
+        }
+        PyList_SET_ITEM(predicates, i, entry);
+    }
+
+    PyObject * result = Py_BuildValue("{s:K,s:K,s:N}",
+        "calls", (unsigned long long)adaptive->calls.load(std::memory_order_relaxed),
+        "reorders", (unsigned long long)adaptive->reorders.load(std::memory_order_relaxed),
+        "predicates", predicates);
+    return result;
+}
+
+static PyObject * reorder(ManyPredicate * self, PyObject * unused) {
+    if (self->adaptive) self->adaptive->reorder(self->npredicates);
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef methods[] = {
+    {"adaptive_info", (PyCFunction)adaptive_info, METH_NOARGS,
+     "adaptive_info()\n--\n\n"
+     "Counters of an adaptive predicate, or None if it isn't adaptive: calls,\n"
+     "reorders and, per predicate in evaluation order, the sampled evals, how\n"
+     "often it decided the result and the cycles it took (halved on reorder)."},
+    {"reorder", (PyCFunction)reorder, METH_NOARGS,
+     "reorder()\n--\n\n"
+     "Reorder an adaptive predicate from its counters now."},
+    {NULL}  // Sentinel
+};
+
+static PyGetSetDef getset[] = {
+    {"order", (getter)order, nullptr, "The predicates in the order they are evaluated.", nullptr},
+    {NULL}  /* Sentinel */
+};
+
 static void dealloc(ManyPredicate *self) {
     PyObject_GC_UnTrack(self);          // Untrack from the GC
     clear(self);
+    PyMem_Free(self->predicates);
+    delete self->adaptive;
     if (self->weakreflist) {
         PyObject_ClearWeakRefs(self);
     }
@@ -115,5 +355,7 @@ PyTypeObject ManyPredicate_Type = {
     .tp_clear = (inquiry)clear,
     .tp_richcompare = richcompare,
     .tp_weaklistoffset = OFFSET_OF_MEMBER(ManyPredicate, weakreflist),
-    .tp_members = members
+    .tp_methods = methods,
+    .tp_members = members,
+    .tp_getset = getset,
 };
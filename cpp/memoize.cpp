@@ -1,66 +1,265 @@
 #include "functional.h"
 #include <structmember.h>
+#include <mutex>
+#include <vector>
 #include "unordered_dense.h"
 
 using namespace ankerl::unordered_dense;
 
+// Entries live in a slot array indexed from the map, so the LRU links are
+// plain indices that survive the map moving its values around. When bounded
+// the slot array is reserved up front and a hit never allocates.
+
+static constexpr uint32_t NIL = UINT32_MAX;
+
+enum class Policy { UNBOUNDED, LRU, CLOCK };
+
+struct Slot {
+    PyObject * key;         // borrowed when weakref is set, owned otherwise
+    PyObject * result;
+    PyObject * weakref;     // evicts the entry when key dies, or nullptr
+    uint32_t prev;          // LRU links, next doubles as the free list link
+    uint32_t next;
+    bool referenced;        // CLOCK second-chance bit
+};
+
+// One independently locked partition of the cache. Eviction order and
+// maxsize are tracked per shard; with the GIL there is a single shard.
+struct Shard {
+    ShardLock lock;
+    map<PyObject *, uint32_t> weakref_to_slot;
+    map<PyObject *, uint32_t> m_cache;
+    std::vector<Slot> slots;
+    uint32_t head;          // most recently used
+    uint32_t tail;          // least recently used
+    uint32_t free_list;
+    uint32_t hand;          // CLOCK position
+    Py_ssize_t capacity;    // -1 when unbounded
+    Policy policy;
+    CacheStats stats;
+
+    Shard() : weakref_to_slot(), m_cache(), slots(),
+        head(NIL), tail(NIL), free_list(NIL), hand(0), capacity(-1), policy(Policy::UNBOUNDED) {}
+
+    void init(Py_ssize_t capacity, Policy policy) {
+        this->capacity = capacity;
+        this->policy = policy;
+
+        if (policy != Policy::UNBOUNDED) {
+            slots.reserve(capacity);
+            m_cache.reserve(capacity);
+        }
+    }
+
+    void unlink(uint32_t i) {
+        Slot & slot = slots[i];
+        if (slot.prev != NIL) slots[slot.prev].next = slot.next; else head = slot.next;
+        if (slot.next != NIL) slots[slot.next].prev = slot.prev; else tail = slot.prev;
+    }
+
+    void push_front(uint32_t i) {
+        Slot & slot = slots[i];
+        slot.prev = NIL;
+        slot.next = head;
+        if (head != NIL) slots[head].prev = i; else tail = i;
+        head = i;
+    }
+
+    void touch(uint32_t i) {
+        switch (policy) {
+            case Policy::LRU:
+                if (head != i) {
+                    unlink(i);
+                    push_front(i);
+                }
+                break;
+            case Policy::CLOCK:
+                slots[i].referenced = true;
+                break;
+            case Policy::UNBOUNDED:
+                break;
+        }
+    }
+
+    uint32_t victim() {
+        if (policy == Policy::LRU) return tail;
+
+        // Every slot is live when the shard is full, so the hand just sweeps
+        // the slot array giving referenced entries a second chance.
+        for (;;) {
+            uint32_t i = hand;
+            hand = (hand + 1) % slots.size();
+            if (!slots[i].referenced) return i;
+            slots[i].referenced = false;
+        }
+    }
+
+    // Unhooks the slot and returns the references it held via `garbage` so
+    // the caller can drop them once the lock is released.
+    void detach(uint32_t i, PyObject * garbage[3]) {
+        Slot & slot = slots[i];
+
+        m_cache.erase(slot.key);
+
+        if (slot.weakref) {
+            weakref_to_slot.erase(slot.weakref);
+            garbage[0] = slot.weakref;
+        } else {
+            garbage[0] = slot.key;
+        }
+        garbage[1] = slot.result;
+        garbage[2] = nullptr;
+
+        if (policy == Policy::LRU) unlink(i);
+
+        slot.key = slot.result = slot.weakref = nullptr;
+        slot.next = free_list;
+        free_list = i;
+    }
+
+    void release(uint32_t i) {
+        PyObject * garbage[3];
+        detach(i, garbage);
+        for (PyObject * obj : garbage) Py_XDECREF(obj);
+    }
+
+    uint32_t allocate() {
+        if (free_list != NIL) {
+            uint32_t i = free_list;
+            free_list = slots[i].next;
+            return i;
+        }
+        slots.push_back(Slot());
+        return (uint32_t)(slots.size() - 1);
+    }
+
+    // Takes the references to key (when not weakly held), result and
+    // weakref. An evicted entry's references are handed back via garbage.
+    void insert(PyObject * key, PyObject * result, PyObject * weakref, PyObject * garbage[3]) {
+        if (capacity >= 0 && (Py_ssize_t)m_cache.size() >= capacity) {
+            stats.evict();
+            detach(victim(), garbage);
+        }
+
+        uint32_t i = allocate();
+        Slot & slot = slots[i];
+
+        slot.key = key;
+        slot.result = result;
+        slot.weakref = weakref;
+        slot.referenced = true;
+
+        if (weakref) weakref_to_slot[weakref] = i;
+        m_cache[key] = i;
+
+        if (policy == Policy::LRU) push_front(i);
+    }
+
+    size_t bytes() const {
+        return map_bytes(m_cache) + map_bytes(weakref_to_slot) + slots.capacity() * sizeof(Slot);
+    }
+};
+
 struct Memoize {
     PyObject_HEAD
     PyObject * target;
     PyObject * callback;
-    map<PyObject *, PyObject *> weakref_to_key;
-    map<PyObject *, PyObject *> m_cache;
+    Py_ssize_t maxsize;
+    uint32_t nshards;
+    Shard shards[CACHE_SHARDS];
+
+    Memoize(PyObject * target, Py_ssize_t maxsize, Policy policy) :
+        target(Py_NewRef(target)), maxsize(maxsize) {
+
+        // Small bounded caches stay in one shard so maxsize remains a
+        // useful bound on each shard's eviction order.
+        nshards = policy == Policy::UNBOUNDED || maxsize >= CACHE_SHARDS * 16 ? CACHE_SHARDS : 1;
+
+        for (uint32_t s = 0; s < nshards; s++) {
+            Py_ssize_t capacity = -1;
 
-    Memoize(PyObject * target) : target(Py_NewRef(target)), weakref_to_key(), m_cache() {}
+            if (policy != Policy::UNBOUNDED) {
+                capacity = maxsize / nshards + ((Py_ssize_t)s < maxsize % nshards);
+            }
+            shards[s].init(capacity, policy);
+        }
+    }
     ~Memoize() {}
 
     vectorcallfunc vectorcall;
-};
 
-static void delete_key(Memoize * self, PyObject * key) {
-    auto it = self->m_cache.find(key);
-    if (it != self->m_cache.end()) {
-        self->m_cache.erase(key);
-        Py_DECREF(it->second);
+    Shard & shard(PyObject * key) {
+        if (CACHE_SHARDS == 1) return shards[0];
+        return shards[shard_index(hash<PyObject *>{}(key), nshards)];
     }
-}
+};
 
 static PyObject * weakref_callback(Memoize * self, PyObject * weakref) {
 
-    auto it = self->weakref_to_key.find(weakref);
+    // the key is already gone, so look for its weakref in every shard
+    for (uint32_t s = 0; s < self->nshards; s++) {
+        Shard & shard = self->shards[s];
+        PyObject * garbage[3] = {nullptr, nullptr, nullptr};
+
+        {
+            std::lock_guard<ShardLock> guard(shard.lock);
 
-    if (it != self->weakref_to_key.end()) {
-        self->weakref_to_key.erase(it);
-        delete_key(self, it->second);
-        // Py_DECREF(it->first);
+            auto it = shard.weakref_to_slot.find(weakref);
+            if (it == shard.weakref_to_slot.end()) continue;
+
+            shard.stats.weakref_evict();
+            shard.detach(it->second, garbage);
+        }
+        for (PyObject * obj : garbage) Py_XDECREF(obj);
+        break;
     }
     Py_RETURN_NONE;
 }
 
 static PyObject * memo_one_arg(Memoize * self, PyObject * arg) {
-    auto it = self->m_cache.find(arg);
+    Shard & shard = self->shard(arg);
 
-    if (it == self->m_cache.end()) {
-
-        PyObject * res = PyObject_CallOneArg(self->target, arg);
+    {
+        std::lock_guard<ShardLock> guard(shard.lock);
 
-        if (!res) return nullptr;
-    
-        PyObject * weakref = PyWeakref_NewRef(arg, self->callback);
+        auto it = shard.m_cache.find(arg);
 
-        if (weakref) {
-            self->weakref_to_key[weakref] = arg;
+        if (it != shard.m_cache.end()) {
+            shard.stats.hit();
+            shard.touch(it->second);
+            return Py_NewRef(shard.slots[it->second].result);
         }
-        else {
-            PyErr_Clear();
-            Py_INCREF(arg);
-        }
-        self->m_cache[arg] = res;
+        shard.stats.miss();
+    }
 
-        return Py_NewRef(res);
-    } else {
-        return Py_NewRef(it->second);
+    PyObject * res = PyObject_CallOneArg(self->target, arg);
+
+    if (!res) return nullptr;
+
+    // created before taking the lock as it allocates
+    PyObject * weakref = PyWeakref_NewRef(arg, self->callback);
+
+    if (!weakref) {
+        PyErr_Clear();
     }
+
+    PyObject * garbage[3] = {nullptr, nullptr, nullptr};
+
+    {
+        std::lock_guard<ShardLock> guard(shard.lock);
+
+        // the target may have re-entered with the same argument, or another
+        // thread got there first
+        if (shard.m_cache.contains(arg)) {
+            garbage[0] = weakref;
+        } else {
+            shard.insert(weakref ? arg : Py_NewRef(arg), Py_NewRef(res), weakref, garbage);
+        }
+    }
+
+    for (PyObject * obj : garbage) Py_XDECREF(obj);
+
+    return res;
 }
 
 static PyObject * vectorcall_one_arg(Memoize * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
@@ -68,9 +267,7 @@ static PyObject * vectorcall_one_arg(Memoize * self, PyObject** args, size_t nar
     size_t nargs = PyVectorcall_NARGS(nargsf);
 
     if (nargs != 1 || kwnames) {
-        raise(SIGTRAP);
-
-        PyErr_SetString(PyExc_TypeError, "Memo only takes one arg");
+        PyErr_SetString(PyExc_TypeError, "memoize_one_arg takes exactly one positional argument, use memoize for multiple arguments");
         return nullptr;
     }
     return memo_one_arg(self, args[0]);
@@ -79,6 +276,16 @@ static PyObject * vectorcall_one_arg(Memoize * self, PyObject** args, size_t nar
 static int traverse(Memoize* self, visitproc visit, void* arg) {
     Py_VISIT(self->target);
     Py_VISIT(self->callback);
+
+    for (uint32_t s = 0; s < self->nshards; s++) {
+        Shard & shard = self->shards[s];
+
+        for (auto & entry : shard.m_cache) {
+            Slot & slot = shard.slots[entry.second];
+            if (!slot.weakref) Py_VISIT(slot.key);
+            Py_VISIT(slot.result);
+        }
+    }
     return 0;
 }
 
@@ -86,12 +293,13 @@ static int clear(Memoize* self) {
     Py_CLEAR(self->target);
     Py_CLEAR(self->callback);
 
-    for (auto it : self->m_cache) {
-        Py_DECREF(it.first);
-        Py_DECREF(it.second);
-    }
-    self->m_cache.clear();
+    for (uint32_t s = 0; s < self->nshards; s++) {
+        Shard & shard = self->shards[s];
 
+        while (!shard.m_cache.empty()) {
+            shard.release(shard.m_cache.begin()->second);
+        }
+    }
     return 0;
 }
 
@@ -102,29 +310,105 @@ static void dealloc(Memoize *self) {
     Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
 }
 
+PyObject * cache_info(CacheStats const & stats, size_t size, Py_ssize_t maxsize, size_t bytes) {
+#if CACHE_STATS
+    return Py_BuildValue("{sKsKsKsKsnsnsn}",
+        "hits", (unsigned long long)stats.hits,
+        "misses", (unsigned long long)stats.misses,
+        "evictions", (unsigned long long)stats.evictions,
+        "weakref_evictions", (unsigned long long)stats.weakref_evictions,
+        "size", (Py_ssize_t)size,
+        "maxsize", maxsize,
+        "bytes", (Py_ssize_t)bytes);
+#else
+    return Py_BuildValue("{snsnsn}",
+        "size", (Py_ssize_t)size,
+        "maxsize", maxsize,
+        "bytes", (Py_ssize_t)bytes);
+#endif
+}
+
+static PyObject * py_cache_info(Memoize * self, PyObject * unused) {
+    CacheStats stats;
+    size_t size = 0, bytes = 0;
+
+    for (uint32_t s = 0; s < self->nshards; s++) {
+        Shard & shard = self->shards[s];
+        std::lock_guard<ShardLock> guard(shard.lock);
+
+        stats += shard.stats;
+        size += shard.m_cache.size();
+        bytes += shard.bytes();
+    }
+    return cache_info(stats, size, self->maxsize, bytes);
+}
+
+static PyMethodDef methods[] = {
+    {"cache_info", (PyCFunction)py_cache_info, METH_NOARGS,
+     "cache_info()\n--\n\n"
+     "Return a dict of cache counters: hits, misses, evictions (maxsize),\n"
+     "weakref_evictions (keys garbage collected), size, maxsize (-1 when\n"
+     "unbounded) and approximate bytes held by the cache's tables."},
+    {NULL}  /* Sentinel */
+};
+
 static PyMemberDef members[] = {
     {"target", T_OBJECT, offsetof(Memoize, target), READONLY, "The wrapped function being memoized."},
+    {"maxsize", T_PYSSIZET, offsetof(Memoize, maxsize), READONLY, "Maximum number of cached entries, or -1 when unbounded."},
     {NULL}  /* Sentinel */
 };
 
+static int parse_policy(PyObject * maxsize_obj, const char * policy_name, Py_ssize_t * maxsize, Policy * policy) {
+    if (!maxsize_obj || maxsize_obj == Py_None) {
+        *maxsize = -1;
+        *policy = Policy::UNBOUNDED;
+        return 0;
+    }
+
+    *maxsize = PyLong_AsSsize_t(maxsize_obj);
+    if (*maxsize == -1 && PyErr_Occurred()) return -1;
+
+    if (*maxsize <= 0 || *maxsize >= (Py_ssize_t)NIL) {
+        PyErr_Format(PyExc_ValueError, "maxsize must be None or a positive int, not %S", maxsize_obj);
+        return -1;
+    }
+
+    if (!policy_name || !strcmp(policy_name, "lru")) {
+        *policy = Policy::LRU;
+    } else if (!strcmp(policy_name, "clock")) {
+        *policy = Policy::CLOCK;
+    } else {
+        PyErr_Format(PyExc_ValueError, "policy must be 'lru' or 'clock', not '%s'", policy_name);
+        return -1;
+    }
+    return 0;
+}
+
 static PyObject * create(PyTypeObject *type, PyObject *args, PyObject *kwds) {
 
     PyObject * target;
-    
-    static const char *kwlist[] = {"target", NULL};
+    PyObject * maxsize_obj = nullptr;
+    const char * policy_name = nullptr;
+
+    static const char *kwlist[] = {"target", "maxsize", "policy", NULL};
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", (char **)kwlist, &target))
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|Os", (char **)kwlist, &target, &maxsize_obj, &policy_name))
     {
         return NULL; // Return NULL on failure
     }
-    
+
+    Py_ssize_t maxsize;
+    Policy policy;
+
+    if (parse_policy(maxsize_obj, policy_name, &maxsize, &policy) < 0) return NULL;
+
     Memoize * self = (Memoize *)type->tp_alloc(type, 0);
 
     if (!self) {
         return NULL;
     }
 
-    new (self) Memoize(target);
+    new (self) Memoize(target, maxsize, policy);
 
     static PyMethodDef def = { "weakref_callback", (PyCFunction)weakref_callback, METH_O, "Internal callback to evict cache entries when keys are garbage collected." };
 
@@ -144,13 +428,18 @@ PyTypeObject Memoize_Type = {
     .tp_vectorcall_offset = offsetof(Memoize, vectorcall),
     .tp_call = PyVectorcall_Call,
     .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_HAVE_VECTORCALL,
-    .tp_doc = "memoize_one_arg(target)\n--\n\n"
+    .tp_doc = "memoize_one_arg(target, maxsize=None, policy='lru')\n--\n\n"
                "Memoize a single-argument function using object identity.\n\n"
                "Uses a high-performance C++ hash map (unordered_dense) for O(1) lookups.\n"
                "Automatically evicts cached entries when keys are garbage collected\n"
-               "via weak references.\n\n"
+               "via weak references. Keys that cannot be weakly referenced are held\n"
+               "strongly, so long-lived caches over such keys should set maxsize.\n\n"
                "Args:\n"
-               "    target: A callable that takes exactly one argument.\n\n"
+               "    target: A callable that takes exactly one argument.\n"
+               "    maxsize: Maximum number of entries, or None for unbounded.\n"
+               "    policy: Eviction policy when bounded: 'lru' evicts the least\n"
+               "            recently used entry, 'clock' is a cheaper second-chance\n"
+               "            approximation of LRU.\n\n"
                "Returns:\n"
                "    A memoized version of the function.\n\n"
                "Example:\n"
@@ -161,7 +450,7 @@ PyTypeObject Memoize_Type = {
                "    >>> expensive(x)  # cached",
     .tp_traverse = (traverseproc)traverse,
     .tp_clear = (inquiry)clear,
-    // .tp_methods = methods,
+    .tp_methods = methods,
     .tp_members = members,
     .tp_new = (newfunc)create,
 };
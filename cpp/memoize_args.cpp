@@ -0,0 +1,475 @@
+#include "functional.h"
+#include <structmember.h>
+#include "unordered_dense.h"
+
+using namespace ankerl::unordered_dense;
+
+// ============================================================================
+// MemoizeArgs — memoize over the full vectorcall argument vector.
+//
+// The key is the positional args, the keyword names and the keyword values
+// taken straight from the vectorcall `args` array. A lookup hashes the array
+// in place and probes the map with a borrowed view, so a cache hit never
+// allocates. Only a miss packs the arguments into a tuple to own them.
+//
+// Each argument is keyed either by identity (the default, same as
+// memoize_one_arg) or by value (__hash__/__eq__), selected per positional
+// index or keyword name with `by_value`.
+//
+// Keyword order is significant: f(a=1, b=2) and f(b=2, a=1) are different
+// keys, as with functools.lru_cache.
+// ============================================================================
+
+struct KeyModes {
+    bool all_by_value;
+    uint64_t positions;     // bit i set => positional arg i is keyed by value
+    PyObject * keywords;    // frozenset of keyword names keyed by value, or nullptr
+
+    bool positional(Py_ssize_t i) const {
+        return all_by_value || (i < 64 && ((positions >> i) & 1));
+    }
+
+    bool keyword(PyObject * name) const {
+        return all_by_value || (keywords && PySet_Contains(keywords, name) == 1);
+    }
+
+    bool at(Py_ssize_t i, Py_ssize_t nargs, PyObject * kwnames) const {
+        return i < nargs ? positional(i) : keyword(PyTuple_GET_ITEM(kwnames, i - nargs));
+    }
+};
+
+// Borrowed view of a call's arguments, used for lookups.
+struct ArgsView {
+    uint64_t hash;
+    KeyModes const * modes;
+    Py_ssize_t nargs;
+    PyObject * const * args;
+    PyObject * kwnames;
+};
+
+// Owned key stored in the map.
+struct ArgsKey {
+    uint64_t hash;
+    KeyModes const * modes;
+    Py_ssize_t nargs;
+    PyObject * values;      // tuple: positional args followed by keyword values
+    PyObject * kwnames;     // nullptr when called without keywords
+};
+
+static bool same_kwnames(PyObject * a, PyObject * b) {
+    if (a == b) return true;
+    if (!a || !b || PyTuple_GET_SIZE(a) != PyTuple_GET_SIZE(b)) return false;
+
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(a); i++) {
+        PyObject * x = PyTuple_GET_ITEM(a, i);
+        PyObject * y = PyTuple_GET_ITEM(b, i);
+        if (x != y && PyUnicode_Compare(x, y) != 0) return false;
+    }
+    return true;
+}
+
+static bool same_args(KeyModes const * modes, Py_ssize_t nargs, PyObject * kwnames,
+                      PyObject * const * a, PyObject * const * b, Py_ssize_t n) {
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (a[i] == b[i]) continue;
+        if (!modes->at(i, nargs, kwnames)) return false;
+
+        // a previous comparison in this probe raised, stop comparing
+        if (PyErr_Occurred()) return false;
+
+        // on -1 the error is left set for the caller to report
+        if (PyObject_RichCompareBool(a[i], b[i], Py_EQ) != 1) return false;
+    }
+    return true;
+}
+
+static inline Py_ssize_t key_size(Py_ssize_t nargs, PyObject * kwnames) {
+    return nargs + (kwnames ? PyTuple_GET_SIZE(kwnames) : 0);
+}
+
+struct ArgsHash {
+    using is_transparent = void;
+
+    size_t operator()(ArgsKey const & key) const { return key.hash; }
+    size_t operator()(ArgsView const & view) const { return view.hash; }
+};
+
+struct ArgsEqual {
+    using is_transparent = void;
+
+    bool operator()(ArgsKey const & a, ArgsKey const & b) const {
+        return a.hash == b.hash &&
+               a.nargs == b.nargs &&
+               PyTuple_GET_SIZE(a.values) == PyTuple_GET_SIZE(b.values) &&
+               same_kwnames(a.kwnames, b.kwnames) &&
+               same_args(a.modes, a.nargs, a.kwnames,
+                         PySequence_Fast_ITEMS(a.values), PySequence_Fast_ITEMS(b.values),
+                         PyTuple_GET_SIZE(a.values));
+    }
+
+    bool operator()(ArgsView const & v, ArgsKey const & k) const {
+        Py_ssize_t n = key_size(v.nargs, v.kwnames);
+
+        return v.hash == k.hash &&
+               v.nargs == k.nargs &&
+               PyTuple_GET_SIZE(k.values) == n &&
+               same_kwnames(v.kwnames, k.kwnames) &&
+               same_args(v.modes, v.nargs, v.kwnames, v.args, PySequence_Fast_ITEMS(k.values), n);
+    }
+
+    bool operator()(ArgsKey const & k, ArgsView const & v) const { return (*this)(v, k); }
+};
+
+static inline uint64_t combine(uint64_t h, uint64_t v) {
+    return detail::wyhash::mix(h ^ v, UINT64_C(0x9E3779B97F4A7C15));
+}
+
+// Returns -1 with an exception set if a by-value argument is unhashable.
+static int hash_args(ArgsView & view) {
+    uint64_t h = combine(0, (uint64_t)view.nargs);
+
+    Py_ssize_t n = key_size(view.nargs, view.kwnames);
+
+    for (Py_ssize_t i = 0; i < n; i++) {
+        PyObject * arg = view.args[i];
+
+        if (view.modes->at(i, view.nargs, view.kwnames)) {
+            Py_hash_t item = PyObject_Hash(arg);
+            if (item == -1) return -1;
+            h = combine(h, (uint64_t)item);
+        } else {
+            h = combine(h, hash<PyObject *>{}(arg));
+        }
+    }
+    if (view.kwnames) {
+        for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(view.kwnames); i++) {
+            h = combine(h, (uint64_t)PyObject_Hash(PyTuple_GET_ITEM(view.kwnames, i)));
+        }
+    }
+    view.hash = h;
+    return 0;
+}
+
+struct MemoizeArgs : public PyObject {
+    retracesoftware::FastCall target;
+    KeyModes modes;
+    // set while the map is being probed or modified; a __eq__ that calls back
+    // into this memoize bypasses the cache instead of mutating the map under us
+    bool busy;
+    map<ArgsKey, PyObject *, ArgsHash, ArgsEqual> m_cache;
+    CacheStats stats;
+    vectorcallfunc vectorcall;
+
+    MemoizeArgs(PyObject * target, KeyModes modes) : target(Py_NewRef(target)), modes(modes), busy(false), m_cache() {}
+    ~MemoizeArgs() {}
+
+    // Drops every entry, unless the map is being probed, in which case it
+    // returns false and leaves the map alone.
+    bool release_all() {
+        map<ArgsKey, PyObject *, ArgsHash, ArgsEqual> old;
+        bool probing;
+
+        Py_BEGIN_CRITICAL_SECTION(this);
+        probing = busy;
+        if (!probing) old = std::move(m_cache);
+        Py_END_CRITICAL_SECTION();
+
+        for (auto & entry : old) {
+            Py_DECREF(entry.first.values);
+            Py_XDECREF(entry.first.kwnames);
+            Py_DECREF(entry.second);
+        }
+        return !probing;
+    }
+
+    static PyObject * call(MemoizeArgs * self, PyObject * const * args, size_t nargsf, PyObject * kwnames) {
+
+        if (self->busy) {
+            return self->target(args, nargsf, kwnames);
+        }
+
+        ArgsView view = {0, &self->modes, (Py_ssize_t)PyVectorcall_NARGS(nargsf), args, kwnames};
+
+        if (hash_args(view) < 0) return nullptr;
+
+        // Probing may run __eq__, so free-threaded builds guard the map with
+        // a critical section rather than a lock that could be held across
+        // Python code. A thread that gets in while the section is suspended
+        // sees busy and bypasses the cache.
+        PyObject * cached = nullptr;
+        bool bypass;
+
+        Py_BEGIN_CRITICAL_SECTION(self);
+        bypass = self->busy;
+        if (!bypass) {
+            self->busy = true;
+            auto it = self->m_cache.find(view);
+            self->busy = false;
+
+            if (it != self->m_cache.end()) {
+                self->stats.hit();
+                cached = Py_NewRef(it->second);
+            } else if (!PyErr_Occurred()) {
+                self->stats.miss();
+            }
+        }
+        Py_END_CRITICAL_SECTION();
+
+        if (bypass) return self->target(args, nargsf, kwnames);
+        if (cached) return cached;
+        if (PyErr_Occurred()) return nullptr;
+
+        PyObject * result = self->target(args, nargsf, kwnames);
+        if (!result) return nullptr;
+
+        Py_ssize_t n = key_size(view.nargs, kwnames);
+
+        PyObject * values = PyTuple_New(n);
+        if (!values) {
+            Py_DECREF(result);
+            return nullptr;
+        }
+        for (Py_ssize_t i = 0; i < n; i++) {
+            PyTuple_SET_ITEM(values, i, Py_NewRef(args[i]));
+        }
+
+        ArgsKey key = {view.hash, &self->modes, view.nargs, values, Py_XNewRef(kwnames)};
+
+        bool inserted = false;
+
+        Py_BEGIN_CRITICAL_SECTION(self);
+        if (!self->busy) {
+            self->busy = true;
+            inserted = self->m_cache.try_emplace(key, result).second;
+            self->busy = false;
+        }
+        Py_END_CRITICAL_SECTION();
+
+        if (!inserted) {
+            // the target re-entered with the same arguments and already
+            // populated the entry, another thread was probing the map, or
+            // comparing keys raised
+            Py_DECREF(values);
+            Py_XDECREF(kwnames);
+            if (PyErr_Occurred()) {
+                Py_DECREF(result);
+                return nullptr;
+            }
+            return result;
+        }
+        return Py_NewRef(result);
+    }
+
+    static int traverse(MemoizeArgs * self, visitproc visit, void * arg) {
+        Py_VISIT(self->target.callable);
+        Py_VISIT(self->modes.keywords);
+
+        for (auto & entry : self->m_cache) {
+            Py_VISIT(entry.first.values);
+            Py_VISIT(entry.second);
+        }
+        return 0;
+    }
+
+    static int clear(MemoizeArgs * self) {
+        Py_CLEAR(self->target.callable);
+        Py_CLEAR(self->modes.keywords);
+        self->release_all();
+        return 0;
+    }
+
+    static void dealloc(MemoizeArgs * self) {
+        PyObject_GC_UnTrack(self);
+        clear(self);
+        self->~MemoizeArgs();
+        Py_TYPE(self)->tp_free((PyObject *)self);
+    }
+
+    static PyObject * py_clear(MemoizeArgs * self, PyObject * unused) {
+        if (!self->release_all()) {
+            PyErr_SetString(PyExc_RuntimeError, "memoize cannot be cleared while its cache is being probed");
+            return nullptr;
+        }
+        Py_RETURN_NONE;
+    }
+
+    static PyObject * py_cache_info(MemoizeArgs * self, PyObject * unused) {
+        PyObject * info;
+
+        Py_BEGIN_CRITICAL_SECTION(self);
+        info = cache_info(self->stats, self->m_cache.size(), -1, map_bytes(self->m_cache));
+        Py_END_CRITICAL_SECTION();
+        return info;
+    }
+
+    static PyObject * size(MemoizeArgs * self, void * closure) {
+        size_t n;
+
+        Py_BEGIN_CRITICAL_SECTION(self);
+        n = self->m_cache.size();
+        Py_END_CRITICAL_SECTION();
+        return PyLong_FromSize_t(n);
+    }
+
+    static int parse_modes(PyObject * by_value, KeyModes * modes) {
+        modes->all_by_value = false;
+        modes->positions = 0;
+        modes->keywords = nullptr;
+
+        if (!by_value || by_value == Py_False || by_value == Py_None) return 0;
+
+        if (by_value == Py_True) {
+            modes->all_by_value = true;
+            return 0;
+        }
+
+        PyObject * names = PySet_New(nullptr);
+        if (!names) return -1;
+
+        PyObject * iter = PyObject_GetIter(by_value);
+        if (!iter) {
+            Py_DECREF(names);
+            PyErr_Format(PyExc_TypeError, "by_value must be a bool or an iterable of positions and keyword names, not %S", by_value);
+            return -1;
+        }
+
+        PyObject * item;
+        while ((item = PyIter_Next(iter))) {
+            if (PyUnicode_Check(item)) {
+                if (PySet_Add(names, item) < 0) goto error;
+            } else if (PyLong_Check(item)) {
+                long pos = PyLong_AsLong(item);
+                if (pos == -1 && PyErr_Occurred()) goto error;
+                if (pos < 0 || pos >= 64) {
+                    PyErr_Format(PyExc_ValueError, "by_value position %S must be between 0 and 63", item);
+                    goto error;
+                }
+                modes->positions |= UINT64_C(1) << pos;
+            } else {
+                PyErr_Format(PyExc_TypeError, "by_value entries must be int positions or str keyword names, not %S", item);
+                goto error;
+            }
+            Py_DECREF(item);
+        }
+        Py_DECREF(iter);
+
+        if (PyErr_Occurred()) {
+            Py_DECREF(names);
+            return -1;
+        }
+
+        if (PySet_GET_SIZE(names) > 0) {
+            modes->keywords = PyFrozenSet_New(names);
+            if (!modes->keywords) {
+                Py_DECREF(names);
+                return -1;
+            }
+        }
+        Py_DECREF(names);
+        return 0;
+
+    error:
+        Py_DECREF(item);
+        Py_DECREF(iter);
+        Py_DECREF(names);
+        return -1;
+    }
+
+    static PyObject * create(PyTypeObject * type, PyObject * args, PyObject * kwds) {
+        PyObject * target;
+        PyObject * by_value = nullptr;
+
+        static const char * kwlist[] = {"target", "by_value", NULL};
+
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O", (char **)kwlist, &target, &by_value)) {
+            return nullptr;
+        }
+
+        if (!PyCallable_Check(target)) {
+            PyErr_Format(PyExc_TypeError, "memoize target must be callable, got %S", target);
+            return nullptr;
+        }
+
+        KeyModes modes;
+        if (parse_modes(by_value, &modes) < 0) return nullptr;
+
+        MemoizeArgs * self = (MemoizeArgs *)type->tp_alloc(type, 0);
+        if (!self) {
+            Py_XDECREF(modes.keywords);
+            return nullptr;
+        }
+
+        new (self) MemoizeArgs(target, modes);
+        self->vectorcall = (vectorcallfunc)MemoizeArgs::call;
+
+        return (PyObject *)self;
+    }
+
+    static PyObject * descr_get(PyObject * self, PyObject * obj, PyObject * type) {
+        return obj == NULL || obj == Py_None ? Py_NewRef(self) : PyMethod_New(self, obj);
+    }
+};
+
+static PyObject * repr(MemoizeArgs * self) {
+    return PyUnicode_FromFormat(MODULE "memoize(%R)", self->target.callable);
+}
+
+static PyMemberDef members[] = {
+    {"target", T_OBJECT, OFFSET_OF_MEMBER(MemoizeArgs, target.callable), READONLY, "The wrapped function being memoized."},
+    {NULL}  /* Sentinel */
+};
+
+static PyGetSetDef getset[] = {
+    {"size", (getter)MemoizeArgs::size, nullptr, "Number of cached entries.", nullptr},
+    {NULL}  /* Sentinel */
+};
+
+static PyMethodDef methods[] = {
+    {"clear", (PyCFunction)MemoizeArgs::py_clear, METH_NOARGS, "Drop all cached entries."},
+    {"cache_info", (PyCFunction)MemoizeArgs::py_cache_info, METH_NOARGS,
+     "cache_info()\n--\n\n"
+     "Return a dict of cache counters: hits, misses, size, maxsize and\n"
+     "approximate bytes held by the cache's tables (keys and results\n"
+     "themselves are not counted)."},
+    {NULL}  /* Sentinel */
+};
+
+PyTypeObject MemoizeArgs_Type = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE "memoize",
+    .tp_basicsize = sizeof(MemoizeArgs),
+    .tp_itemsize = 0,
+    .tp_dealloc = (destructor)MemoizeArgs::dealloc,
+    .tp_vectorcall_offset = OFFSET_OF_MEMBER(MemoizeArgs, vectorcall),
+    .tp_repr = (reprfunc)repr,
+    .tp_call = PyVectorcall_Call,
+    .tp_str = (reprfunc)repr,
+    .tp_flags = Py_TPFLAGS_DEFAULT |
+                Py_TPFLAGS_HAVE_GC |
+                Py_TPFLAGS_HAVE_VECTORCALL |
+                Py_TPFLAGS_METHOD_DESCRIPTOR,
+    .tp_doc = "memoize(target, by_value=False)\n--\n\n"
+               "Memoize a function over all of its positional and keyword arguments.\n\n"
+               "The arguments are hashed straight from the vectorcall argument array,\n"
+               "so a cache hit does not allocate. Arguments are keyed by identity\n"
+               "unless selected by by_value, in which case __hash__/__eq__ is used.\n"
+               "Cached keys and results are held by strong reference.\n\n"
+               "Args:\n"
+               "    target: The callable to memoize.\n"
+               "    by_value: True to key every argument by value, or an iterable of\n"
+               "              positional indices (int) and keyword names (str) to key\n"
+               "              by value. Everything else is keyed by identity.\n\n"
+               "Returns:\n"
+               "    A memoized version of the function.\n\n"
+               "Example:\n"
+               "    >>> lookup = memoize(resolve, by_value=[1, 'mode'])\n"
+               "    >>> lookup(cls, 'name', mode='r')  # computed\n"
+               "    >>> lookup(cls, 'name', mode='r')  # cached",
+    .tp_traverse = (traverseproc)MemoizeArgs::traverse,
+    .tp_clear = (inquiry)MemoizeArgs::clear,
+    .tp_methods = methods,
+    .tp_members = members,
+    .tp_getset = getset,
+    .tp_descr_get = MemoizeArgs::descr_get,
+    .tp_new = (newfunc)MemoizeArgs::create,
+};
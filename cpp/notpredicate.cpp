@@ -5,24 +5,20 @@ struct NotPredicate {
     PyObject_HEAD
     PyObject * pred;
     vectorcallfunc vectorcall;
+    Predicate test;
 };
 
-static PyObject * vectorcall(NotPredicate * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
-
-    PyObject * result = PyObject_Vectorcall(self->pred, args, nargsf, kwnames);
+int notpredicate_test(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames) {
+    int status = ((NotPredicate *)pred)->test(args, nargsf, kwnames);
+    return status < 0 ? status : !status;
+}
 
-    if (!result) return NULL;
+static PyObject * vectorcall(NotPredicate * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
 
-    switch (PyObject_IsTrue(result)) {
-        case 0: 
-            Py_DECREF(result);
-            Py_RETURN_TRUE;
-        case 1:
-            Py_DECREF(result);
-            Py_RETURN_FALSE;
-        default:
-            Py_DECREF(result);
-            return NULL;
+    switch (notpredicate_test((PyObject *)self, args, nargsf, kwnames)) {
+        case 0: Py_RETURN_FALSE;
+        case 1: Py_RETURN_TRUE;
+        default: return nullptr;
     }
 }
 
@@ -66,6 +62,7 @@ static PyObject * create(PyTypeObject *type, PyObject *args, PyObject *kwds) {
     }
 
     self->pred = Py_NewRef(pred);
+    self->test = Predicate(pred);
 
     self->vectorcall = (vectorcallfunc)vectorcall;
 
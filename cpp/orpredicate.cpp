@@ -2,68 +2,25 @@
 #include "tupleobject.h"
 #include <structmember.h>
 
-static int run_predicate(PyObject * pred, PyObject** args, size_t nargsf, PyObject* kwnames) {
-    PyObject * res = PyObject_Vectorcall(pred, args, nargsf, kwnames);
+int orpredicate_test(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames) {
+    ManyPredicate * self = (ManyPredicate *)pred;
 
-    if (!res) return -1;
-    int status = PyObject_IsTrue(res);
-    Py_DECREF(res);
-    return status;
-}
+    if (self->adaptive) return many_predicate_adaptive(self, args, nargsf, kwnames, 1);
 
-static PyObject * vectorcall(ManyPredicate * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
-    if (PyTuple_Check(self->elements)) {
-        for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(self->elements); i++) {
-            PyObject * pred = PyTuple_GET_ITEM(self->elements, i);
-            int status = run_predicate(pred, args, nargsf, kwnames);
+    for (Py_ssize_t i = 0; i < self->npredicates; i++) {
+        int status = self->predicates[i](args, nargsf, kwnames);
 
-            if (status == 1) {
-                Py_RETURN_TRUE;
-            } else if (status == -1) {
-                return NULL;
-            }
-        }
+        if (status != 0) return status;
     }
-    else if (PyList_Check(self->elements)) {
-        for (Py_ssize_t i = 0; i < PyList_GET_SIZE(self->elements); i++) {
-            PyObject * pred = PyList_GET_ITEM(self->elements, i);
-            int status = run_predicate(pred, args, nargsf, kwnames);
-
-            if (status == 1) {
-                Py_RETURN_TRUE;        
-            } else if (status == -1) {
-                return NULL;
-            }
-        }
-    } else {
-        PyObject * iterator = PyObject_GetIter(self->elements);
-
-        if (iterator == NULL) {
-            PyErr_SetString(PyExc_TypeError, "Object is not iterable");
-            return NULL;
-        }
-
-        PyObject * item;
-        // Iterate through the elements
-        while ((item = PyIter_Next(iterator))) {
-
-            int status = run_predicate(item, args, nargsf, kwnames);
-            Py_DECREF(item);
+    return 0;
+}
 
-            if (status == 1) {
-                Py_DECREF(iterator);
-                Py_RETURN_TRUE;        
-            } else if (status == -1) {
-                Py_DECREF(iterator);
-                return NULL;
-            }
-        }
-        Py_DECREF(iterator); 
-        if (PyErr_Occurred()) {
-           return NULL;  // Propagate iteration errors (e.g., inside a generator)
-        }
+static PyObject * vectorcall(ManyPredicate * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    switch (orpredicate_test(self, args, nargsf, kwnames)) {
+        case 0: Py_RETURN_FALSE;
+        case 1: Py_RETURN_TRUE;
+        default: return nullptr;
     }
-    Py_RETURN_FALSE;
 }
 
 static PyObject * create(PyTypeObject *type, PyObject *args, PyObject *kwds) {
@@ -85,6 +42,11 @@ static PyObject * create(PyTypeObject *type, PyObject *args, PyObject *kwds) {
 
     self->elements = Py_NewRef(args);
 
+    if (many_predicate_init(self, kwds) < 0) {
+        Py_DECREF(self);
+        return NULL;
+    }
+
     self->vectorcall = (vectorcallfunc)vectorcall;
 
     return (PyObject *)self;
@@ -98,12 +60,15 @@ PyTypeObject OrPredicate_Type = {
     .tp_vectorcall_offset = ManyPredicate_Type.tp_vectorcall_offset,
     .tp_call = PyVectorcall_Call,
     .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_HAVE_VECTORCALL,
-    .tp_doc = "or_predicate(*predicates)\n--\n\n"
+    .tp_doc = "or_predicate(*predicates, adaptive=False)\n--\n\n"
                "Combine predicates with logical OR (short-circuit evaluation).\n\n"
                "Returns True if any predicate returns a truthy value.\n"
                "Short-circuits on the first truthy result.\n\n"
                "Args:\n"
-               "    *predicates: Callable predicates to combine.\n\n"
+               "    *predicates: Callable predicates to combine.\n"
+               "    adaptive: Reorder the predicates as they run, putting the cheapest\n"
+               "        and most often truthy first. Only for predicates without side\n"
+               "        effects; at most 16. See order and adaptive_info().\n\n"
                "Returns:\n"
                "    A predicate that returns True if any predicate is truthy.\n\n"
                "Example:\n"
@@ -1,4 +1,45 @@
 #include "functional.h"
+#include <algorithm>
+#include <vector>
+
+PyObject * Placeholder = nullptr;
+
+static PyObject * placeholder_repr(PyObject * self) {
+    return PyUnicode_FromString("Placeholder");
+}
+
+static PyObject * placeholder_reduce(PyObject * self, PyObject * unused) {
+    return PyUnicode_FromString("Placeholder");
+}
+
+static PyMethodDef placeholder_methods[] = {
+    {"__reduce__", (PyCFunction)placeholder_reduce, METH_NOARGS, "Pickle as the module's singleton"},
+    {NULL, NULL, 0, NULL}
+};
+
+PyTypeObject Placeholder_Type = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE "_PlaceholderType",
+    .tp_basicsize = sizeof(PyObject),
+    .tp_repr = placeholder_repr,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Type of Placeholder, which marks a partial argument filled at call time.",
+    .tp_methods = placeholder_methods,
+};
+
+// Same string, comparing by identity first: keyword names are almost
+// always interned.
+static bool has_name(PyObject * names, PyObject * name) {
+    Py_ssize_t n = PyTuple_GET_SIZE(names);
+
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (PyTuple_GET_ITEM(names, i) == name) return true;
+    }
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (PyUnicode_Compare(PyTuple_GET_ITEM(names, i), name) == 0) return true;
+    }
+    return false;
+}
 
 struct Partial : public PyVarObject {
     vectorcallfunc vectorcall;
@@ -8,10 +49,21 @@ struct Partial : public PyVarObject {
     // PyObject * function;        
     // vectorcallfunc function_vectorcall;
     int required;
+    // args holds the bound positionals followed by the bound keyword values,
+    // which is the vectorcall layout for kwnames; ob_size counts both.
+    Py_ssize_t nargs;
+    PyObject * kwnames;     // names of the bound keywords, or nullptr
+    // Positions in args holding Placeholder, in order; the leading call-time
+    // positionals go there. PyMem block, nullptr when there are none.
+    Py_ssize_t * holes;
+    Py_ssize_t nholes;
     PyObject * args[];
 
+    Py_ssize_t nkwargs() const { return ob_size - nargs; }
+
     static int clear(Partial* self) {
         Py_CLEAR(self->function.callable);
+        Py_CLEAR(self->kwnames);
         for (int i = 0; i < self->ob_size; i++) {
             Py_CLEAR(self->args[i]);
         }
@@ -30,6 +82,7 @@ struct Partial : public PyVarObject {
         PyObject_GC_UnTrack(self);          // Untrack from the GC
 
         clear(self);
+        PyMem_Free(self->holes);
         Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
     }
 
@@ -37,35 +90,202 @@ struct Partial : public PyVarObject {
         return PyObject_GetAttr(self->function.callable, name);
     }
 
-    static PyObject * call(Partial * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+    // Fills the placeholders from the leading call-time positionals and
+    // merges keywords, a call-time keyword replacing a bound one of the same
+    // name.
+    static PyObject * call_general(Partial * self, PyObject ** args, size_t nargs, PyObject * kwnames) {
+        if (nargs < (size_t)self->nholes) {
+            PyErr_Format(PyExc_TypeError,
+                         "missing positional arguments in 'partial' call; expected at least %zd, got %zu",
+                         self->nholes, nargs);
+            return nullptr;
+        }
+
+        Py_ssize_t nbound = self->nkwargs();
+        Py_ssize_t ncall = kwnames ? PyTuple_GET_SIZE(kwnames) : 0;
+        size_t npositional = self->nargs + nargs - self->nholes;
+
+        bool * overridden = (bool *)alloca(nbound);
+        Py_ssize_t nkept = 0;
+
+        for (Py_ssize_t i = 0; i < nbound; i++) {
+            overridden[i] = ncall && has_name(kwnames, PyTuple_GET_ITEM(self->kwnames, i));
+            if (!overridden[i]) nkept++;
+        }
 
-        size_t nargs = PyVectorcall_NARGS(nargsf) + (kwnames ? PyTuple_GET_SIZE(kwnames) : 0);
+        PyObject * names;
 
-        if (nargs == 0 || self->required == 0) {
-            return self->function(self->args, self->ob_size, nullptr);
+        if (!ncall) {
+            names = Py_XNewRef(self->kwnames);
+        } else if (!nbound) {
+            names = Py_NewRef(kwnames);
         } else {
-            size_t total_args = self->ob_size + nargs;
+            names = PyTuple_New(nkept + ncall);
+            if (!names) return nullptr;
+        }
 
-            assert(self->required == -1);
+        PyObject ** mem = (PyObject **)alloca(sizeof(PyObject *) * (npositional + nkept + ncall + 1)) + 1;
 
-            if (self->required == -1 || self->required == total_args) { 
-                PyObject ** mem = (PyObject **)alloca(sizeof(PyObject *) * (total_args + 1)) + 1;
+        for (Py_ssize_t i = 0; i < self->nargs; i++) {
+            mem[i] = self->args[i];
+        }
+        for (Py_ssize_t i = 0; i < self->nholes; i++) {
+            mem[self->holes[i]] = args[i];
+        }
+        for (size_t i = self->nholes; i < nargs; i++) {
+            mem[i + self->nargs - self->nholes] = args[i];
+        }
 
-                for (size_t i = 0; i < (size_t)self->ob_size; i++) {
-                    mem[i] = self->args[i];
-                }
+        PyObject ** values = mem + npositional;
+        Py_ssize_t n = 0;
 
-                for (size_t i = 0; i < nargs; i++) {
-                    mem[i + self->ob_size] = args[i];
-                }
+        for (Py_ssize_t i = 0; i < nbound; i++) {
+            if (overridden[i]) continue;
+            if (ncall) PyTuple_SET_ITEM(names, n, Py_NewRef(PyTuple_GET_ITEM(self->kwnames, i)));
+            values[n++] = self->args[self->nargs + i];
+        }
+        for (Py_ssize_t i = 0; i < ncall; i++) {
+            if (nbound) PyTuple_SET_ITEM(names, n, Py_NewRef(PyTuple_GET_ITEM(kwnames, i)));
+            values[n++] = args[nargs + i];
+        }
+
+        PyObject * result = self->function(mem, npositional | PY_VECTORCALL_ARGUMENTS_OFFSET, names);
+        Py_XDECREF(names);
+        return result;
+    }
+
+    // One bound positional and the caller lent us args[-1]: prepend in
+    // place, as bound methods do. The slot before that isn't ours, so the
+    // flag isn't passed on.
+    static bool can_prepend(Partial * self, size_t nargsf) {
+        return (nargsf & PY_VECTORCALL_ARGUMENTS_OFFSET) && self->nargs == 1 && self->ob_size == 1;
+    }
+
+    static PyObject * call_prepend(Partial * self, PyObject ** args, size_t nargsf, PyObject * kwnames) {
+        PyObject ** stack = args - 1;
+        PyObject * saved = stack[0];
 
-                nargsf = (self->ob_size + PyVectorcall_NARGS(nargsf)) | PY_VECTORCALL_ARGUMENTS_OFFSET;
+        stack[0] = self->args[0];
+        PyObject * result = self->function(stack, PyVectorcall_NARGS(nargsf) + 1, kwnames);
+        stack[0] = saved;
+
+        return result;
+    }
 
-                return self->function(mem, nargsf, kwnames);
+    // required=-1: any call-time arguments, appended to the bound ones.
+    static PyObject * call(Partial * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+
+        size_t nkwargs = kwnames ? PyTuple_GET_SIZE(kwnames) : 0;
+        size_t nargs = PyVectorcall_NARGS(nargsf) + nkwargs;
+
+        if (nargs == 0 && !self->nholes) {
+            // the bound arguments are already laid out for the call
+            return self->function(self->args, self->nargs, self->kwnames);
+        } else if (can_prepend(self, nargsf)) {
+            return call_prepend(self, args, nargsf, kwnames);
+        } else if (self->nholes || (nkwargs && self->kwnames)) {
+            return call_general(self, args, PyVectorcall_NARGS(nargsf), kwnames);
+        } else {
+            // at most one side has keywords, whose values go last
+            size_t nbound_kw = self->nkwargs();
+            size_t total_args = self->nargs + nargs + nbound_kw;
+
+            PyObject ** mem = (PyObject **)alloca(sizeof(PyObject *) * (total_args + 1)) + 1;
+
+            for (size_t i = 0; i < (size_t)self->nargs; i++) {
+                mem[i] = self->args[i];
             }
+
+            for (size_t i = 0; i < nargs; i++) {
+                mem[i + self->nargs] = args[i];
+            }
+
+            for (size_t i = 0; i < nbound_kw; i++) {
+                mem[i + self->nargs + nargs] = self->args[i + self->nargs];
+            }
+
+            nargsf = (self->nargs + PyVectorcall_NARGS(nargsf)) | PY_VECTORCALL_ARGUMENTS_OFFSET;
+
+            return self->function(mem, nargsf, nkwargs ? kwnames : self->kwnames);
         }
     }
 
+    // required=0: call-time arguments are ignored.
+    static PyObject * call0(Partial * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+        return self->function(self->args, self->nargs, self->kwnames);
+    }
+
+    // required=N > 0: exactly N call-time positionals.
+    bool check_arity(size_t nargs) {
+        if (nargs == (size_t)required) return true;
+
+        PyErr_Format(PyExc_TypeError, "partial of %R takes %d positional argument%s (%zu given)",
+                     function.callable, required, required == 1 ? "" : "s", nargs);
+        return false;
+    }
+
+    // Fixed arity with no placeholders and at most SMALL_ARGS bound
+    // arguments: stack is sized by the caller for n call-time positionals.
+    PyObject * call_using(size_t n, PyObject ** stack, PyObject ** args, size_t nargsf, PyObject * kwnames) {
+        if (!check_arity(PyVectorcall_NARGS(nargsf))) return nullptr;
+        if (can_prepend(this, nargsf)) return call_prepend(this, args, nargsf, kwnames);
+        if (kwnames) return call_general(this, args, n, kwnames);
+
+        for (Py_ssize_t i = 0; i < nargs; i++) {
+            stack[i] = this->args[i];
+        }
+        for (size_t i = 0; i < n; i++) {
+            stack[nargs + i] = args[i];
+        }
+        for (Py_ssize_t i = 0; i < nkwargs(); i++) {
+            stack[nargs + n + i] = this->args[nargs + i];
+        }
+        return function(stack, (nargs + n) | PY_VECTORCALL_ARGUMENTS_OFFSET, this->kwnames);
+    }
+
+    static PyObject * call1(Partial * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+        PyObject * stack[SMALL_ARGS + 2];
+        return self->call_using(1, stack + 1, args, nargsf, kwnames);
+    }
+
+    static PyObject * call2(Partial * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+        PyObject * stack[SMALL_ARGS + 3];
+        return self->call_using(2, stack + 1, args, nargsf, kwnames);
+    }
+
+    static PyObject * call3(Partial * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+        PyObject * stack[SMALL_ARGS + 4];
+        return self->call_using(3, stack + 1, args, nargsf, kwnames);
+    }
+
+    static PyObject * callN(Partial * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+        size_t nargs = PyVectorcall_NARGS(nargsf);
+        return self->check_arity(nargs) ? call_general(self, args, nargs, kwnames) : nullptr;
+    }
+
+    static vectorcallfunc get_vectorcallfunc(Partial * self) {
+        if (self->required < 0) return (vectorcallfunc)call;
+        if (self->required == 0) return (vectorcallfunc)call0;
+        if (self->nholes || self->ob_size > SMALL_ARGS) return (vectorcallfunc)callN;
+
+        switch (self->required) {
+            case 1: return (vectorcallfunc)call1;
+            case 2: return (vectorcallfunc)call2;
+            case 3: return (vectorcallfunc)call3;
+            default: return (vectorcallfunc)callN;
+        }
+    }
+
+    // A plain partial with no instance attributes can be flattened into one
+    // wrapping it: its arguments and keywords come first, with its
+    // placeholders taking the outer positionals.
+    static bool collapsible(PyObject * func) {
+        if (Py_TYPE(func) != &Partial_Type) return false;
+
+        Partial * inner = (Partial *)func;
+        return inner->required == -1 && (!inner->dict || !PyDict_GET_SIZE(inner->dict));
+    }
+
     static PyObject* create(PyTypeObject* type, PyObject* args, PyObject* kwds) {
 
         if (PyTuple_Size(args) == 0) {
@@ -74,41 +294,160 @@ struct Partial : public PyVarObject {
         }
 
         int required = -1;
+        PyObject * required_obj = nullptr;
 
         if (kwds) {
-            PyObject * obj = PyDict_GetItemString(kwds, "required");
+            required_obj = PyDict_GetItemString(kwds, "required");
+
+            if (required_obj) {
+                if (!PyLong_Check(required_obj)) {
+                    PyErr_Format(PyExc_TypeError, "required parameter: %S wasn't int", required_obj);
+                    return nullptr;
+                }
+                int overflow;
+                long value = PyLong_AsLongAndOverflow(required_obj, &overflow);
+
+                if (value == -1 && PyErr_Occurred()) return nullptr;
+
+                if (overflow > 0 || value > INT_MAX) {
+                    PyErr_Format(PyExc_OverflowError, "required parameter: %S is too large", required_obj);
+                    return nullptr;
+                }
+                required = overflow < 0 ? -1 : (int)value;
+
+                if (overflow < 0 || required < 0) {
+                    PyErr_Format(PyExc_TypeError, "required parameter: %S must be >= 0", required_obj);
+                    return nullptr;
+                }
+            }
+        }
+
+        PyObject * function = PyTuple_GET_ITEM(args, 0);
+        Partial * inner = required == -1 && collapsible(function) ? (Partial *)function : nullptr;
+
+        // the positionals, borrowed, with the inner partial's placeholders filled
+        std::vector<PyObject *> positional;
+        Py_ssize_t next = 1;
+
+        if (inner) {
+            function = inner->function.callable;
 
-            if (obj) {
-                if (!PyLong_Check(obj)) {
-                    PyErr_Format(PyExc_TypeError, "required parameter: %S wasn't int", obj);
+            for (Py_ssize_t i = 0; i < inner->nargs; i++) {
+                PyObject * arg = inner->args[i];
+                positional.push_back(arg == Placeholder && next < PyTuple_GET_SIZE(args) ? PyTuple_GET_ITEM(args, next++) : arg);
+            }
+        }
+        for (; next < PyTuple_GET_SIZE(args); next++) {
+            positional.push_back(PyTuple_GET_ITEM(args, next));
+        }
+
+        if (!positional.empty() && positional.back() == Placeholder) {
+            PyErr_SetString(PyExc_TypeError, "trailing Placeholders are not allowed");
+            return nullptr;
+        }
+
+        Py_ssize_t nholes = std::count(positional.begin(), positional.end(), Placeholder);
+
+        if (nholes && required == 0) {
+            PyErr_SetString(PyExc_TypeError, "Placeholders are not allowed with required=0");
+            return nullptr;
+        }
+        if (required > 0 && required < nholes) {
+            // every call would be missing arguments for the Placeholders
+            PyErr_Format(PyExc_TypeError, "required=%d is fewer than the %zd Placeholders", required, nholes);
+            return nullptr;
+        }
+
+        // keywords to bind: the inner partial's, then every one given here
+        // but `required`
+        PyObject * keywords = PyDict_New();
+        if (!keywords) return nullptr;
+
+        if (inner) {
+            for (Py_ssize_t i = 0; i < inner->nkwargs(); i++) {
+                if (PyDict_SetItem(keywords, PyTuple_GET_ITEM(inner->kwnames, i), inner->args[inner->nargs + i]) < 0) {
+                    Py_DECREF(keywords);
+                    return nullptr;
                 }
-                required = PyLong_AsLong(obj);
+            }
+        }
+        if (kwds) {
+            PyObject * key, * value;
+            Py_ssize_t pos = 0;
 
-                if (required < 0) {
-                    PyErr_Format(PyExc_TypeError, "required parameter: %S must be >= 0", obj);
+            while (PyDict_Next(kwds, &pos, &key, &value)) {
+                if (value == required_obj && PyUnicode_CompareWithASCIIString(key, "required") == 0) continue;
+
+                if (value == Placeholder) {
+                    PyErr_SetString(PyExc_TypeError, "Placeholder cannot be passed as a keyword argument");
+                    Py_DECREF(keywords);
+                    return nullptr;
+                }
+                if (PyDict_SetItem(keywords, key, value) < 0) {
+                    Py_DECREF(keywords);
+                    return nullptr;
                 }
             }
         }
 
+        Py_ssize_t nargs = (Py_ssize_t)positional.size();
+        Py_ssize_t nkwargs = PyDict_GET_SIZE(keywords);
+
         // Use PyObject_NewVar to allocate memory for the object
         // Partial* self = (Partial *)Partial_Type.tp_alloc(&Partial_Type, PyTuple_Size(args) - 1);
-        Partial* self = (Partial *)Partial_Type.tp_alloc(type, PyTuple_Size(args) - 1);
+        Partial* self = (Partial *)Partial_Type.tp_alloc(type, nargs + nkwargs);
         
         // Check if the allocation was successful
         if (self == NULL) {
+            Py_DECREF(keywords);
             return NULL; // Return NULL on error
         }
 
-        self->function = retracesoftware::FastCall(Py_NewRef(PyTuple_GetItem(args, 0)));
+        self->function = retracesoftware::FastCall(Py_NewRef(function));
 
-        for (Py_ssize_t i = 0; i < self->ob_size; i++) {
-            self->args[i] = Py_NewRef(PyTuple_GetItem(args, i + 1));
+        for (Py_ssize_t i = 0; i < nargs; i++) {
+            self->args[i] = Py_NewRef(positional[i]);
         }
 
-        self->vectorcall = (vectorcallfunc)Partial::call;
         self->dict = NULL;
         self->required = required;
+        self->nargs = nargs;
+        self->kwnames = nullptr;
+        self->holes = nullptr;
+        self->nholes = 0;
+
+        if (nholes) {
+            self->holes = PyMem_New(Py_ssize_t, nholes);
+            if (!self->holes) {
+                Py_DECREF(keywords);
+                Py_DECREF(self);
+                return PyErr_NoMemory();
+            }
+            for (Py_ssize_t i = 0; i < nargs; i++) {
+                if (positional[i] == Placeholder) self->holes[self->nholes++] = i;
+            }
+        }
+
+        if (nkwargs) {
+            self->kwnames = PyTuple_New(nkwargs);
+            if (!self->kwnames) {
+                Py_DECREF(keywords);
+                Py_DECREF(self);
+                return nullptr;
+            }
+
+            PyObject * key, * value;
+            Py_ssize_t pos = 0, i = 0;
+
+            while (PyDict_Next(keywords, &pos, &key, &value)) {
+                PyTuple_SET_ITEM(self->kwnames, i, Py_NewRef(key));
+                self->args[nargs + i] = Py_NewRef(value);
+                i++;
+            }
+        }
+        Py_DECREF(keywords);
 
+        self->vectorcall = get_vectorcallfunc(self);
         return (PyObject*)self;
     }
 
@@ -124,7 +463,9 @@ static PyObject * repr(Partial *self) {
     if (!result) return nullptr;
 
     for (Py_ssize_t i = 0; i < Py_SIZE(self); ++i) {
-        PyObject *item_repr = PyUnicode_FromFormat(", %S", self->args[i]);
+        PyObject *item_repr = i < self->nargs
+            ? PyUnicode_FromFormat(", %S", self->args[i])
+            : PyUnicode_FromFormat(", %U=%S", PyTuple_GET_ITEM(self->kwnames, i - self->nargs), self->args[i]);
 
         if (item_repr == NULL) {
             Py_DECREF(result);
@@ -162,7 +503,7 @@ PyTypeObject Partial_Type = {
                 Py_TPFLAGS_HAVE_VECTORCALL | 
                 Py_TPFLAGS_METHOD_DESCRIPTOR |
                 Py_TPFLAGS_BASETYPE,
-    .tp_doc = "partial(func, *args, required=None)\n--\n\n"
+    .tp_doc = "partial(func, *args, required=None, **kwargs)\n--\n\n"
                "Create a partial application of a function with fixed arguments.\n\n"
                "Similar to functools.partial but optimized with vectorcall and\n"
                "stack-based argument concatenation for minimal overhead.\n\n"
@@ -170,7 +511,15 @@ PyTypeObject Partial_Type = {
                "    func: The callable to partially apply.\n"
                "    *args: Positional arguments to prepend on each call.\n"
                "    required: If set to 0, call immediately with stored args only.\n"
-               "              If -1 (default), concatenate additional args on call.\n\n"
+               "              If N > 0, every call must pass exactly N positional\n"
+               "              arguments, else TypeError.\n"
+               "              If unset, concatenate additional args on call.\n"
+               "    **kwargs: Keyword arguments to pass on each call. A keyword\n"
+               "              given at call time replaces a bound one of the same\n"
+               "              name. 'required' can't be bound.\n\n"
+               "Placeholder in *args leaves that position open; the leading\n"
+               "call-time positionals fill the open positions in order. A partial\n"
+               "of a plain partial is flattened into one.\n\n"
                "Returns:\n"
                "    A callable that prepends the stored args to any new arguments.\n\n"
                "Example:\n"
@@ -185,7 +534,9 @@ PyTypeObject Partial_Type = {
 
     // .tp_methods = methods,
     // .tp_members = members,
+    .tp_alloc = pool_alloc,
     .tp_new = (newfunc)Partial::create,
+    .tp_free = pool_free,
     // .tp_init = (initproc)Partial::init,
     // .tp_new = PyType_GenericNew,
 };
@@ -205,6 +556,11 @@ PyObject * partial(PyObject * function, PyObject * const * args, size_t nargs) {
     }
     self->vectorcall = (vectorcallfunc)Partial::call;
     self->function = Py_NewRef(function);
+    self->required = -1;
+    self->nargs = nargs;
+    self->kwnames = nullptr;
+    self->holes = nullptr;
+    self->nholes = 0;
 
     return (PyObject *)self;
 }
@@ -0,0 +1,155 @@
+#include "functional.h"
+#include <string.h>
+
+// Blocks are sized in pointer steps, as _PyObject_VAR_SIZE rounds them.
+static constexpr size_t pool_step = SIZEOF_VOID_P;
+static constexpr size_t pool_max_block = 256;
+static constexpr size_t pool_buckets = pool_max_block / pool_step;
+
+static FREELIST_LOCAL FreeList pool[pool_buckets];
+
+enum FreeListState {
+    FREELISTS_UNREGISTERED,     // free-threaded: no drain hook on this thread yet
+    FREELISTS_OPEN,             // caching
+    FREELISTS_CLOSED,           // drained, frees go to the allocator
+};
+
+#ifdef Py_GIL_DISABLED
+static thread_local FreeListState state = FREELISTS_UNREGISTERED;
+#else
+static FreeListState state = FREELISTS_OPEN;
+#endif
+
+#ifdef Py_GIL_DISABLED
+static const char * drain_key = MODULE "freelists";
+
+static void drain_thread(PyObject * capsule) {
+    pool_close();
+}
+
+// Hooks the calling thread's freelists to its thread state dict, whose
+// clearing at thread exit drains them while the thread is still attached.
+// Without a hook the thread doesn't cache at all.
+static void register_thread() {
+    state = FREELISTS_CLOSED;
+
+    PyObject * raised = fetch_error();
+    PyObject * dict = PyThreadState_GetDict();
+    PyObject * capsule = dict ? PyCapsule_New(&state, drain_key, drain_thread) : nullptr;
+
+    if (capsule && PyDict_SetItemString(dict, drain_key, capsule) == 0) {
+        state = FREELISTS_OPEN;
+    }
+    Py_XDECREF(capsule);
+    PyErr_Clear();
+    if (raised) restore_error(raised);
+}
+#endif
+
+size_t alloc_size(PyTypeObject * type, Py_ssize_t nitems) {
+    // PyType_GenericAlloc leaves room for a sentinel item
+    return _Py_SIZE_ROUND_UP(type->tp_basicsize + (nitems + 1) * type->tp_itemsize, SIZEOF_VOID_P);
+}
+
+PyObject * FreeList::alloc(PyTypeObject * type, Py_ssize_t nitems) {
+#ifdef Py_GIL_DISABLED
+    if (state == FREELISTS_UNREGISTERED) register_thread();
+#endif
+    if (!size) {
+        stats.miss();
+        return PyType_GenericAlloc(type, nitems);
+    }
+    stats.hit();
+
+    PyObject * obj = items[--size];
+    memset((void *)obj, 0, alloc_size(type, nitems));
+
+    if (type->tp_itemsize) {
+        PyObject_InitVar((PyVarObject *)obj, type, nitems);
+    } else {
+        PyObject_Init(obj, type);
+    }
+    PyObject_GC_Track(obj);
+    return obj;
+}
+
+void FreeList::release(PyObject * obj) {
+    // a thread that never allocated here has no drain hook, nor a list to keep
+    if (size < capacity && state == FREELISTS_OPEN) {
+        items[size++] = obj;
+    } else {
+        stats.evict();
+        PyObject_GC_Del(obj);
+    }
+}
+
+void FreeList::drain() {
+    while (size) PyObject_GC_Del(items[--size]);
+}
+
+void pool_close() {
+    state = FREELISTS_CLOSED;
+
+    for (FreeList & list : pool) list.drain();
+    deepwrap_freelist().drain();
+}
+
+// Only blocks GenericAlloc lays out with no pre-header can be shared, which
+// rules out heap types (managed dict and weakref slots on 3.12+). Partial
+// and lazy construct their subclasses through the base's tp_alloc.
+static FreeList * bucket(PyTypeObject * type, size_t size) {
+    if (type->tp_flags & Py_TPFLAGS_HEAPTYPE || size > pool_max_block) return nullptr;
+    return &pool[size / pool_step - 1];
+}
+
+PyObject * pool_alloc(PyTypeObject * type, Py_ssize_t nitems) {
+    FreeList * list = bucket(type, alloc_size(type, nitems));
+    return list ? list->alloc(type, nitems) : PyType_GenericAlloc(type, nitems);
+}
+
+void pool_free(void * ptr) {
+    PyObject * obj = (PyObject *)ptr;
+    PyTypeObject * type = Py_TYPE(obj);
+
+    FreeList * list = bucket(type, alloc_size(type, type->tp_itemsize ? Py_SIZE(obj) : 0));
+
+    if (list) {
+        list->release(obj);
+    } else {
+        PyObject_GC_Del(obj);
+    }
+}
+
+PyObject * pool_info() {
+    FreeList & deepwrap = deepwrap_freelist();
+
+    PyObject * info = PyDict_New();
+    if (!info) return nullptr;
+
+    PyObject * item = cache_info(deepwrap.stats, deepwrap.size, FreeList::capacity,
+                                 deepwrap.size * alloc_size(&DeepWrap_Type, 0));
+
+    if (!item || PyDict_SetItemString(info, "deepwrap", item) < 0) goto error;
+    Py_DECREF(item);
+
+    {
+        CacheStats stats;
+        size_t size = 0, bytes = 0;
+
+        for (size_t i = 0; i < pool_buckets; i++) {
+            stats += pool[i].stats;
+            size += pool[i].size;
+            bytes += pool[i].size * (i + 1) * pool_step;
+        }
+        item = cache_info(stats, size, FreeList::capacity * pool_buckets, bytes);
+    }
+    if (!item || PyDict_SetItemString(info, "shared", item) < 0) goto error;
+    Py_DECREF(item);
+
+    return info;
+
+error:
+    Py_XDECREF(item);
+    Py_DECREF(info);
+    return nullptr;
+}
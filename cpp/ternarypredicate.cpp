@@ -6,17 +6,10 @@ struct TernaryPredicate : PyObject {
     PyObject * on_true;
     PyObject * on_false;
     vectorcallfunc vectorcall;
+    Predicate test;
 
     static PyObject * call(TernaryPredicate * self, PyObject* const * args, size_t nargsf, PyObject* kwnames) {
-        PyObject * branch = PyObject_Vectorcall(self->condition, args, nargsf, kwnames);
-
-        if (!branch) return nullptr;
-
-        int res = PyObject_IsTrue(branch);
-
-        Py_DECREF(branch);
-
-        switch (res) {
+        switch (self->test(args, nargsf, kwnames)) {
             case 0:
                 return PyObject_Vectorcall(self->on_false, args, nargsf, kwnames);
             case 1:
@@ -53,9 +46,10 @@ struct TernaryPredicate : PyObject {
             return -1; // Return NULL on failure
         }
 
-        self->condition = Py_NewRef(condition);
-        self->on_true = Py_NewRef(on_true);
-        self->on_false = Py_NewRef(on_false);
+        Py_XSETREF(self->condition, Py_NewRef(condition));
+        self->test = Predicate(condition);
+        Py_XSETREF(self->on_true, Py_NewRef(on_true));
+        Py_XSETREF(self->on_false, Py_NewRef(on_false));
         self->vectorcall = (vectorcallfunc)call;
         return 0;
     }
@@ -0,0 +1,513 @@
+#include "functional.h"
+#include <structmember.h>
+#include <algorithm>
+#include <new>
+#include <vector>
+
+struct ThreadLocalProxy;
+
+// Per-thread binding. The proxy's TSS key points at the calling thread's
+// slot, which caches the target's vectorcall so a call is a TSS load plus a
+// direct call. A slot is listed both by its proxy and by its thread's
+// SlotOwner and is freed by whichever of the two goes first.
+struct Slot {
+    retracesoftware::FastCall target;
+    ThreadLocalProxy * proxy;
+    struct SlotOwner * owner;
+};
+
+// The slots of one thread, kept in a capsule in the thread state dict. The
+// dict is cleared while the thread is still attached, as it exits, which
+// unbinds the thread from every proxy it touched.
+struct SlotOwner {
+    std::vector<Slot *> slots;
+};
+
+// Guards slot registration, Slot::proxy/owner and both slot lists, which
+// threads and proxies tear down concurrently on free-threaded builds. Never
+// held across a call back into Python, decrefs included.
+static ShardLock slots_lock;
+
+static const char * slot_owner_key = MODULE "ThreadLocalProxy.slots";
+
+template<typename T>
+static void erase_slot(std::vector<T *> & slots, T * slot) {
+    slots.erase(std::remove(slots.begin(), slots.end(), slot), slots.end());
+}
+
+static void release_slots(PyObject * capsule);
+
+struct ThreadLocalProxy : public PyObject {
+    Py_tss_t tls;
+    vectorcallfunc vectorcall;
+    PyObject * error;
+    std::vector<Slot *> slots;
+
+    static PyObject * create(PyTypeObject * type, PyObject * args, PyObject * kwds) {
+        static const char *kwlist[] = { "error", NULL};
+
+        PyObject * error = nullptr;
+
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", (char **)kwlist, &error))
+        {
+            return nullptr; // Return NULL on failure
+        }
+
+        if (error == Py_None) error = nullptr;
+
+        if (error && !PyExceptionClass_Check(error)) {
+            PyErr_Format(PyExc_TypeError, "ThreadLocalProxy error must be an exception class, got %S", error);
+            return nullptr;
+        }
+
+        ThreadLocalProxy * proxy = (ThreadLocalProxy *)type->tp_alloc(type, 0);
+        if (!proxy) return nullptr;
+
+        new (&proxy->slots) std::vector<Slot *>();
+        proxy->tls = Py_tss_NEEDS_INIT;
+        proxy->vectorcall = (vectorcallfunc)call;
+        proxy->error = Py_XNewRef(error);
+
+        if (PyThread_tss_create(&proxy->tls) != 0) {
+            Py_DECREF(proxy);
+            PyErr_SetString(PyExc_RuntimeError, "failed to create TSS key");
+            return nullptr;
+        }
+        return proxy;
+    }
+
+    Slot * slot() { return reinterpret_cast<Slot *>(PyThread_tss_get(&tls)); }
+
+    // The calling thread's SlotOwner, created on first use.
+    static SlotOwner * thread_owner() {
+        PyObject * dict = PyThreadState_GetDict();
+        if (!dict) {
+            PyErr_SetString(PyExc_RuntimeError, "ThreadLocalProxy needs a thread state");
+            return nullptr;
+        }
+
+        PyObject * capsule = PyDict_GetItemString(dict, slot_owner_key);
+        if (capsule) {
+            return (SlotOwner *)PyCapsule_GetPointer(capsule, slot_owner_key);
+        }
+
+        SlotOwner * owner = new (std::nothrow) SlotOwner();
+        if (!owner) {
+            PyErr_NoMemory();
+            return nullptr;
+        }
+
+        capsule = PyCapsule_New(owner, slot_owner_key, release_slots);
+        if (!capsule) {
+            delete owner;
+            return nullptr;
+        }
+
+        int status = PyDict_SetItemString(dict, slot_owner_key, capsule);
+        Py_DECREF(capsule);
+        return status < 0 ? nullptr : owner;
+    }
+
+    Slot * ensure_slot() {
+        Slot * s = slot();
+        if (s) return s;
+
+        SlotOwner * owner = thread_owner();
+        if (!owner) return nullptr;
+
+        s = new (std::nothrow) Slot{retracesoftware::FastCall(), this, owner};
+        if (!s) {
+            PyErr_NoMemory();
+            return nullptr;
+        }
+
+        bool registered = true;
+
+        slots_lock.lock();
+        try {
+            slots.push_back(s);
+            try {
+                owner->slots.push_back(s);
+            } catch (std::bad_alloc&) {
+                slots.pop_back();
+                throw;
+            }
+        } catch (std::bad_alloc&) {
+            registered = false;
+        }
+        slots_lock.unlock();
+
+        if (!registered) {
+            delete s;
+            PyErr_NoMemory();
+            return nullptr;
+        }
+
+        if (PyThread_tss_set(&tls, s) != 0) {
+            slots_lock.lock();
+            erase_slot(slots, s);
+            erase_slot(owner->slots, s);
+            slots_lock.unlock();
+            delete s;
+            PyErr_SetString(PyExc_RuntimeError, "failed to set TSS value");
+            return nullptr;
+        }
+        return s;
+    }
+
+    PyObject * get() {
+        Slot * s = slot();
+        return s ? s->target.callable : nullptr;
+    }
+
+    // Rebinds the current thread's target (None unbinds), returning the
+    // previous target as a new reference, or None.
+    PyObject * set(PyObject * target) {
+        Slot * s = target == Py_None ? slot() : ensure_slot();
+
+        if (!s) {
+            return target == Py_None ? Py_NewRef(Py_None) : nullptr;
+        }
+
+        PyObject * prev = s->target.callable;
+
+        s->target = target == Py_None
+            ? retracesoftware::FastCall()
+            : retracesoftware::FastCall(Py_NewRef(target));
+
+        return prev ? prev : Py_NewRef(Py_None);
+    }
+
+    static int traverse(ThreadLocalProxy * proxy, visitproc visit, void * arg) {
+        Py_VISIT(proxy->error);
+
+        for (auto & s : proxy->slots) {
+            Py_VISIT(s->target.callable);
+        }
+        return 0;
+    }
+
+    static int clear(ThreadLocalProxy * proxy) {
+        Py_CLEAR(proxy->error);
+
+        std::vector<PyObject *> targets;
+
+        slots_lock.lock();
+        for (Slot * s : proxy->slots) {
+            if (s->target.callable) targets.push_back(s->target.callable);
+            s->target = retracesoftware::FastCall();
+        }
+        slots_lock.unlock();
+
+        for (PyObject * target : targets) Py_DECREF(target);
+        return 0;
+    }
+
+    static void dealloc(ThreadLocalProxy *proxy) {
+        PyObject_GC_UnTrack(proxy);
+        clear(proxy);
+
+        // Other threads may still point at their slots through the key, so
+        // delete the key before the slots go.
+        if (PyThread_tss_is_created(&proxy->tls)) {
+            PyThread_tss_delete(&proxy->tls);
+        }
+
+        slots_lock.lock();
+        for (Slot * s : proxy->slots) {
+            erase_slot(s->owner->slots, s);
+            delete s;
+        }
+        slots_lock.unlock();
+
+        proxy->slots.~vector();
+        Py_TYPE(proxy)->tp_free((PyObject *)proxy);
+    }
+
+    PyObject * unset() {
+        PyErr_SetNone(error ? error : ThreadLocalError);
+        return nullptr;
+    }
+
+    // New reference to the current thread's target: the target may rebind
+    // the proxy, releasing itself, while it runs.
+    PyObject * target() {
+        PyObject * target = get();
+        return target ? Py_NewRef(target) : unset();
+    }
+
+    static PyObject * getattro(ThreadLocalProxy *self, PyObject *name) {
+        PyObject * obj = self->target();
+        if (!obj) return nullptr;
+
+        PyObject * result = PyObject_GetAttr(obj, name);
+        Py_DECREF(obj);
+        return result;
+    }
+
+    static int setattro(ThreadLocalProxy *self, PyObject * name, PyObject *value) {
+        PyObject * obj = self->target();
+        if (!obj) return -1;
+
+        int status = PyObject_SetAttr(obj, name, value);
+        Py_DECREF(obj);
+        return status;
+    }
+
+    static PyObject * call(ThreadLocalProxy * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
+        Slot * s = self->slot();
+
+        if (s && s->target.callable) {
+            // copy the FastCall and hold the target: rebinding from inside
+            // the call would otherwise free it mid-call
+            retracesoftware::FastCall target = s->target;
+            Py_INCREF(target.callable);
+            PyObject * result = target(args, nargsf, kwnames);
+            Py_DECREF(target.callable);
+            return result;
+        }
+        return self->unset();
+    }
+
+    static PyObject * repr(ThreadLocalProxy *self) {
+        PyObject * target = self->get();
+        if (!target) {
+            return PyUnicode_FromString("<ThreadLocalProxy: unset>");
+        }
+        Py_INCREF(target);
+        PyObject * result = PyObject_Repr(target);
+        Py_DECREF(target);
+        return result;
+    }
+
+    static PyObject * str(ThreadLocalProxy *self) {
+        PyObject * target = self->get();
+        if (!target) {
+            return PyUnicode_FromString("<ThreadLocalProxy: unset>");
+        }
+        Py_INCREF(target);
+        PyObject * result = PyObject_Str(target);
+        Py_DECREF(target);
+        return result;
+    }
+
+    static PyObject * iter(ThreadLocalProxy *self) {
+        PyObject * obj = self->target();
+        if (!obj) return nullptr;
+
+        PyObject * result = PyObject_GetIter(obj);
+        Py_DECREF(obj);
+        return result;
+    }
+
+    static PyObject * iternext(ThreadLocalProxy *self) {
+        PyObject * obj = self->target();
+        if (!obj) return nullptr;
+
+        PyObject * result = PyIter_Next(obj);
+        Py_DECREF(obj);
+        return result;
+    }
+
+    static PyObject * set_classmethod(PyObject *cls, PyObject *args, PyObject * kwds) {
+
+        ThreadLocalProxy * self;
+        PyObject * target;
+
+        static const char *kwlist[] = {"proxy", "target", NULL};
+
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O", (char **)kwlist, &ThreadLocalProxy_Type, &self, &target))
+        {
+            return nullptr; // Return NULL on failure
+        }
+        return self->set(target);
+    }
+
+    static PyObject * get_classmethod(PyObject *cls, PyObject *args, PyObject * kwds) {
+
+        ThreadLocalProxy * self;
+
+        static const char *kwlist[] = {"proxy", NULL};
+
+        if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!", (char **)kwlist, &ThreadLocalProxy_Type, &self))
+        {
+            return nullptr; // Return NULL on failure
+        }
+
+        PyObject * obj = self->get();
+        return Py_NewRef(obj ? obj : Py_None);
+    }
+
+    static PyObject * swap_classmethod(PyObject *cls, PyObject *args, PyObject * kwds);
+};
+
+// Capsule destructor for a thread's SlotOwner, run as the thread state dict
+// is cleared: unregisters the thread's slots from their proxies and drops
+// the targets they held.
+static void release_slots(PyObject * capsule) {
+    SlotOwner * owner = (SlotOwner *)PyCapsule_GetPointer(capsule, slot_owner_key);
+    if (!owner) {
+        PyErr_Clear();
+        return;
+    }
+
+    std::vector<PyObject *> targets;
+
+    slots_lock.lock();
+    for (Slot * s : owner->slots) {
+        ThreadLocalProxy * proxy = s->proxy;
+
+        erase_slot(proxy->slots, s);
+        if (PyThread_tss_get(&proxy->tls) == s) {
+            PyThread_tss_set(&proxy->tls, nullptr);
+        }
+        if (s->target.callable) targets.push_back(s->target.callable);
+        delete s;
+    }
+    slots_lock.unlock();
+
+    delete owner;
+
+    for (PyObject * target : targets) Py_DECREF(target);
+}
+
+// Context manager returned by ThreadLocalProxy.swap(proxy, target). Binds
+// target on __enter__ and restores the previous binding on __exit__, both
+// on the calling thread.
+struct ThreadLocalSwap : public PyObject {
+    ThreadLocalProxy * proxy;
+    PyObject * target;
+    PyObject * previous;
+
+    static PyObject * enter(ThreadLocalSwap * self, PyObject * unused) {
+        if (self->previous) {
+            PyErr_SetString(PyExc_RuntimeError, "ThreadLocalProxy.swap context is already entered");
+            return nullptr;
+        }
+        self->previous = self->proxy->set(self->target);
+
+        return self->previous ? Py_NewRef(self->target) : nullptr;
+    }
+
+    static PyObject * exit(ThreadLocalSwap * self, PyObject * const * args, Py_ssize_t nargs) {
+        if (!self->previous) {
+            PyErr_SetString(PyExc_RuntimeError, "ThreadLocalProxy.swap context was not entered");
+            return nullptr;
+        }
+        PyObject * replaced = self->proxy->set(self->previous);
+        Py_CLEAR(self->previous);
+
+        if (!replaced) return nullptr;
+        Py_DECREF(replaced);
+        Py_RETURN_FALSE;
+    }
+
+    static int traverse(ThreadLocalSwap * self, visitproc visit, void * arg) {
+        Py_VISIT(self->proxy);
+        Py_VISIT(self->target);
+        Py_VISIT(self->previous);
+        return 0;
+    }
+
+    static int clear(ThreadLocalSwap * self) {
+        Py_CLEAR(self->proxy);
+        Py_CLEAR(self->target);
+        Py_CLEAR(self->previous);
+        return 0;
+    }
+
+    static void dealloc(ThreadLocalSwap * self) {
+        PyObject_GC_UnTrack(self);
+        clear(self);
+        Py_TYPE(self)->tp_free((PyObject *)self);
+    }
+};
+
+static PyMethodDef swap_methods[] = {
+    {"__enter__", (PyCFunction)ThreadLocalSwap::enter, METH_NOARGS, "Bind the target on the current thread"},
+    {"__exit__", (PyCFunction)ThreadLocalSwap::exit, METH_FASTCALL, "Restore the previous binding"},
+    {NULL, NULL, 0, NULL}
+};
+
+PyTypeObject ThreadLocalSwap_Type = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE "ThreadLocalSwap",
+    .tp_basicsize = sizeof(ThreadLocalSwap),
+    .tp_itemsize = 0,
+    .tp_dealloc = (destructor)ThreadLocalSwap::dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,
+    .tp_doc = "Context manager returned by ThreadLocalProxy.swap(proxy, target).",
+    .tp_traverse = (traverseproc)ThreadLocalSwap::traverse,
+    .tp_clear = (inquiry)ThreadLocalSwap::clear,
+    .tp_methods = swap_methods,
+    .tp_alloc = pool_alloc,
+    .tp_free = pool_free,
+};
+
+PyObject * ThreadLocalProxy::swap_classmethod(PyObject *cls, PyObject *args, PyObject * kwds) {
+
+    ThreadLocalProxy * proxy;
+    PyObject * target;
+
+    static const char *kwlist[] = {"proxy", "target", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O", (char **)kwlist, &ThreadLocalProxy_Type, &proxy, &target))
+    {
+        return nullptr; // Return NULL on failure
+    }
+
+    ThreadLocalSwap * swap = (ThreadLocalSwap *)ThreadLocalSwap_Type.tp_alloc(&ThreadLocalSwap_Type, 0);
+    if (!swap) return nullptr;
+
+    swap->proxy = (ThreadLocalProxy *)Py_NewRef(proxy);
+    swap->target = Py_NewRef(target);
+    swap->previous = nullptr;
+    return swap;
+}
+
+static PyMethodDef methods[] = {
+    {"set", (PyCFunction)ThreadLocalProxy::set_classmethod, METH_VARARGS | METH_KEYWORDS | METH_CLASS, "Set the thread-local target"},
+    {"get", (PyCFunction)ThreadLocalProxy::get_classmethod, METH_VARARGS | METH_KEYWORDS | METH_CLASS, "Get the thread-local target"},
+    {"swap", (PyCFunction)ThreadLocalProxy::swap_classmethod, METH_VARARGS | METH_KEYWORDS | METH_CLASS,
+     "Context manager binding the thread-local target for the duration of a with block"},
+    {NULL, NULL, 0, NULL}
+};
+
+PyTypeObject ThreadLocalProxy_Type = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE "ThreadLocalProxy",
+    .tp_basicsize = sizeof(ThreadLocalProxy),
+    .tp_itemsize = 0,
+    .tp_dealloc = (destructor)ThreadLocalProxy::dealloc,
+    .tp_vectorcall_offset = OFFSET_OF_MEMBER(ThreadLocalProxy, vectorcall),
+    .tp_repr = (reprfunc)ThreadLocalProxy::repr,
+    .tp_call = PyVectorcall_Call,
+    .tp_str = (reprfunc)ThreadLocalProxy::str,
+    .tp_getattro = (getattrofunc)ThreadLocalProxy::getattro,
+    .tp_setattro = (setattrofunc)ThreadLocalProxy::setattro,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_HAVE_VECTORCALL,
+    .tp_doc = "ThreadLocalProxy(error=None)\n--\n\n"
+               "A proxy object that delegates to a thread-local target.\n\n"
+               "Each thread can have a different target object. Attribute access,\n"
+               "calls, and iteration are forwarded to the current thread's target.\n"
+               "Calls go straight to the target's cached vectorcall.\n"
+               "Use ThreadLocalProxy.set(proxy, target) to set the target.\n\n"
+               "Args:\n"
+               "    error: Exception class to raise when accessed without a target\n"
+               "           set (default ThreadLocalError).\n\n"
+               "Class Methods:\n"
+               "    set(proxy, target): Set this thread's target (returns previous).\n"
+               "    get(proxy): Get this thread's target (or None).\n"
+               "    swap(proxy, target): Context manager that sets this thread's\n"
+               "        target and restores the previous one on exit.\n\n"
+               "Example:\n"
+               "    >>> recorder = ThreadLocalProxy()\n"
+               "    >>> with ThreadLocalProxy.swap(recorder, record_call):\n"
+               "    ...     recorder('open', path)  # calls record_call on this thread",
+    .tp_traverse = (traverseproc)ThreadLocalProxy::traverse,
+    .tp_clear = (inquiry)ThreadLocalProxy::clear,
+    .tp_iter = (getiterfunc)ThreadLocalProxy::iter,
+    .tp_iternext = (iternextfunc)ThreadLocalProxy::iternext,
+    .tp_methods = methods,
+    .tp_new = ThreadLocalProxy::create,
+};
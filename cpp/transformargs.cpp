@@ -54,10 +54,11 @@ static inline PyObject * vectorcall_from(int from, TransformArgs * self, PyObjec
         if (nargs == 0 || nargs == from) {
             return self->func(args, nargsf, nullptr);
         } else if (nargs == 1) {
-            PyObject * transformed = self->transform(args[0]);
-            if (!transformed) return nullptr;
-            PyObject * result = self->func(transformed);
-            Py_DECREF(transformed);
+            // with a spare slot in front, so a partial downstream can prepend in place
+            PyObject * stack[2] = {nullptr, self->transform(args[0])};
+            if (!stack[1]) return nullptr;
+            PyObject * result = self->func(stack + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, nullptr);
+            Py_DECREF(stack[1]);
             return result;
         }
     }
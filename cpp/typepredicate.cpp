@@ -1,11 +1,9 @@
 #include "functional.h"
 #include <structmember.h>
 
-struct TypePredicate {
-    PyObject_HEAD
-    PyTypeObject * cls;
-    vectorcallfunc vectorcall;
-};
+int typepredicate_test(PyObject * pred, PyObject * const * args, size_t nargsf, PyObject * kwnames) {
+    return Py_TYPE(args[0]) == ((TypePredicate *)pred)->cls;
+}
 
 static PyObject * vectorcall(TypePredicate * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
     return PyBool_FromLong(Py_TYPE(args[0]) == self->cls);
@@ -1,129 +1,1011 @@
 #include "functional.h"
 #include <structmember.h>
+#include "unordered_dense.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// How a walker takes apart objects of a given type. Exact tuple, list and
+// dict are handled before any lookup; everything else is resolved once per
+// type through WalkerTypes.
+enum WalkKind {
+    WALK_LEAF,              // passed to the function
+    WALK_HANDLER,           // user-registered handler(obj, walker)
+    WALK_TUPLE_SUBCLASS,    // rebuilt as cls(tuple)
+    WALK_NAMEDTUPLE,        // rebuilt as cls._make(tuple)
+    WALK_LIST_SUBCLASS,     // rebuilt as cls(list)
+    WALK_DICT_SUBCLASS,     // rebuilt from obj.copy()
+    WALK_SET,               // set, frozenset and subclasses
+    WALK_ATTRIBUTES,        // dataclass fields or __slots__, on a copy.copy()
+    WALK_SKIP,              // typed_walker: neither matched nor walked, returned as is
+};
+
+// Per-type resolution cache. Entries are stamped with the type's version
+// tag, so a class modified after it was first walked is resolved again;
+// types without a tag are resolved on every walk.
+struct WalkerTypes {
+    struct Entry {
+        unsigned int version;
+        WalkKind kind;
+        PyObject * data;    // handler or attribute names, owned
+    };
+    using Map = ankerl::unordered_dense::map<PyTypeObject *, Entry>;
+
+    static constexpr size_t max_types = 1024;
+
+    ShardLock lock;
+    Map entries;
+
+    static void release(Map & map) {
+        for (auto & [type, entry] : map) Py_XDECREF(entry.data);
+        map.clear();
+    }
+
+    ~WalkerTypes() { release(entries); }
+
+    void clear() {
+        Map dropped;
+        {
+            std::lock_guard<ShardLock> guard(lock);
+            std::swap(dropped, entries);
+        }
+        release(dropped);
+    }
+
+    // the kind and a new reference to its data, if it has any
+    bool find(PyTypeObject * type, unsigned int version, WalkKind * kind, PyObject ** data) {
+        std::lock_guard<ShardLock> guard(lock);
+
+        auto it = entries.find(type);
+        if (it == entries.end() || it->second.version != version) return false;
+
+        *kind = it->second.kind;
+        *data = Py_XNewRef(it->second.data);
+        return true;
+    }
+
+    void store(PyTypeObject * type, unsigned int version, WalkKind kind, PyObject * data) {
+        Map dropped;
+        PyObject * replaced = nullptr;
+        {
+            std::lock_guard<ShardLock> guard(lock);
+
+            // dead types are never evicted individually, bound them instead
+            if (entries.size() >= max_types) std::swap(dropped, entries);
+
+            auto [it, inserted] = entries.try_emplace(type, Entry {version, kind, Py_XNewRef(data)});
+            if (!inserted) {
+                replaced = it->second.data;
+                it->second = Entry {version, kind, Py_XNewRef(data)};
+            }
+        }
+        Py_XDECREF(replaced);
+        release(dropped);
+    }
+};
 
 struct Walker : public PyObject {
     PyObject * func;
     vectorcallfunc func_vectorcall;
     vectorcallfunc vectorcall;
+    PyObject * handlers;        // type -> handler, nullptr until register()
+    WalkerTypes * types;        // nullptr when only tuple/list/dict are walked
+    int extended;
+    int keys;
+    int preserve_identity;
+    Py_ssize_t parallel;        // threads a large top-level container is split across, 1 for none
+    struct FrameStack * spare_frames;   // reused by the next walk, see acquire_frames
+    // typed_walker only: a tuple of types or a type predicate limiting the
+    // function to matching objects, resolved for the builtins at construction
+    PyObject * gate;
+    unsigned plain_skips;       // plain_leaf bits of the leaf types returned as is
+    unsigned leaf_containers;   // container_bit bits of the exact containers passed to the function
 };
 
-static PyObject * walk(Walker * self, PyObject * arg);
+// Identity memo of a preserve_identity walk: every object reached maps to
+// its walked result, so shared objects are walked once and stay shared,
+// and a container reached again while it is still being walked (a cycle)
+// gets a `pending` stand-in that is filled once the container is done.
+//
+// One memo lives per thread and per top-level call; calls made from
+// inside the walk (a handler walking its parts) share it. Its storage is
+// kept between calls so a steady workload doesn't allocate.
+struct WalkMemo {
+    struct Entry {
+        PyObject * result = nullptr;    // set once walked
+        PyObject * pending = nullptr;   // stand-in handed out to a cycle
+    };
 
-static PyObject * walk_tuple_from(Walker * self, PyObject * tuple, size_t from, PyObject * new_element) {
-    size_t n = PyTuple_GET_SIZE(tuple);
+    static constexpr size_t max_retained = 4096;
 
-    PyObject * new_tuple = PyTuple_New(n);
-    if (!new_tuple) return nullptr;
+    Walker * walker = nullptr;
+    ankerl::unordered_dense::map<PyObject *, Entry> entries;    // keys owned
 
-    for (size_t j = 0; j < from; ++j) {
-        PyTuple_SET_ITEM(new_tuple, j, Py_NewRef(PyTuple_GET_ITEM(tuple, j)));
+    static thread_local WalkMemo * active;
+
+    void reset() {
+        for (auto & [obj, entry] : entries) {
+            Py_DECREF(obj);
+            Py_XDECREF(entry.result);
+            Py_XDECREF(entry.pending);
+        }
+        if (entries.size() > max_retained) entries = {};
+        else entries.clear();
+        walker = nullptr;
     }
-    PyTuple_SET_ITEM(new_tuple, from, new_element);
-    
-    for (size_t i = from + 1; i < n; ++i) {
-        PyObject * elem = PyTuple_GET_ITEM(tuple, i);
-        PyObject * new_elem = walk(self, elem);
+};
 
-        if (!new_elem) {
-            Py_DECREF(new_tuple);
-            return nullptr;
+thread_local WalkMemo * WalkMemo::active = nullptr;
+
+static int set_item(PyObject * dict, PyObject * key, PyObject * value) {
+    // subclasses may keep state of their own (OrderedDict), go through them
+    return PyDict_CheckExact(dict) ? PyDict_SetItem(dict, key, value) : PyObject_SetItem(dict, key, value);
+}
+
+// A dict of the same type as `dict` holding its items, or with none of
+// them when `empty`.
+static PyObject * copy_dict(PyObject * dict, bool empty) {
+    if (PyDict_CheckExact(dict)) return empty ? PyDict_New() : PyDict_Copy(dict);
+
+    PyObject * copy = PyObject_CallMethod(dict, "copy", nullptr);
+
+    if (copy && empty) {
+        PyObject * cleared = PyObject_CallMethod(copy, "clear", nullptr);
+        if (!cleared) Py_CLEAR(copy);
+        Py_XDECREF(cleared);
+    }
+    return copy;
+}
+
+static PyObject * shallow_copy(PyObject * obj) {
+    static PyObject * copy = nullptr;
+
+    if (!copy) {
+        PyObject * module = PyImport_ImportModule("copy");
+        if (!module) return nullptr;
+        copy = PyObject_GetAttrString(module, "copy");
+        Py_DECREF(module);
+        if (!copy) return nullptr;
+    }
+    return PyObject_CallOneArg(copy, obj);
+}
+
+static PyObject * dataclass_fields(PyTypeObject * cls) {
+    PyObject * module = PyImport_ImportModule("dataclasses");
+    if (!module) return nullptr;
+
+    PyObject * fields = PyObject_CallMethod(module, "fields", "O", cls);
+    Py_DECREF(module);
+    if (!fields) return nullptr;
+
+    PyObject * names = PyTuple_New(PyTuple_GET_SIZE(fields));
+
+    for (Py_ssize_t i = 0; names && i < PyTuple_GET_SIZE(fields); i++) {
+        PyObject * name = PyObject_GetAttrString(PyTuple_GET_ITEM(fields, i), "name");
+        if (!name) Py_CLEAR(names);
+        else PyTuple_SET_ITEM(names, i, name);
+    }
+    Py_DECREF(fields);
+    return names;
+}
+
+// The slot names of an instance without a __dict__, from the member
+// descriptors __slots__ put in each Python class of the MRO; nullptr
+// without an error if there are none.
+static PyObject * slot_names(PyTypeObject * cls) {
+    if (cls->tp_dictoffset || !PyType_HasFeature(cls, Py_TPFLAGS_HEAPTYPE)) return nullptr;
+
+    PyObject * names = PyList_New(0);
+    if (!names) return nullptr;
+
+    PyObject * mro = cls->tp_mro;
+
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(mro); i++) {
+        PyTypeObject * base = (PyTypeObject *)PyTuple_GET_ITEM(mro, i);
+        if (!PyType_HasFeature(base, Py_TPFLAGS_HEAPTYPE)) continue;
+
+        Py_ssize_t pos = 0;
+        PyObject *name, *descr;
+
+        while (PyDict_Next(base->tp_dict, &pos, &name, &descr)) {
+            if (Py_IS_TYPE(descr, &PyMemberDescr_Type) && PyList_Append(names, name) < 0) {
+                Py_DECREF(names);
+                return nullptr;
+            }
         }
-        PyTuple_SET_ITEM(new_tuple, i, new_elem);
     }
-    return new_tuple;
+    PyObject * result = PyList_GET_SIZE(names) ? PyList_AsTuple(names) : nullptr;
+    Py_DECREF(names);
+    return result;
 }
 
-static PyObject * walk_tuple(Walker * self, PyObject * tuple) {
-    
-    size_t n = PyTuple_GET_SIZE(tuple);
-
-    for (size_t i = 0; i < n; ++i) {
-        PyObject * elem = PyTuple_GET_ITEM(tuple, i);
-        PyObject * new_elem = walk(self, elem);
-        
-        if (elem == new_elem) {
-            Py_DECREF(new_elem);
-        } else if (!new_elem) {
+static bool has_attribute(PyTypeObject * cls, const char * name) {
+    PyObject * value = PyObject_GetAttrString((PyObject *)cls, name);
+    if (!value) PyErr_Clear();
+    Py_XDECREF(value);
+    return value != nullptr;
+}
+
+// Whether a typed_walker's gate takes instances of `cls`.
+static bool gate_matches(PyObject * gate, PyTypeObject * cls) {
+    if (!PyTuple_CheckExact(gate)) return type_test(gate, cls) == 1;
+
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(gate); i++) {
+        if (PyType_IsSubtype(cls, (PyTypeObject *)PyTuple_GET_ITEM(gate, i))) return true;
+    }
+    return false;
+}
+
+// Bit for the types walked as leaves by any walker without handlers, 0 for
+// other types.
+static inline unsigned plain_leaf(PyTypeObject * cls) {
+    return cls == &PyLong_Type ? 1 : cls == &PyUnicode_Type ? 2 : cls == &PyFloat_Type ? 4 :
+           cls == &PyBool_Type ? 8 : cls == &PyBytes_Type ? 16 : 0;
+}
+
+// Bit for the containers every walker takes apart, 0 for other types.
+static inline unsigned container_bit(PyTypeObject * cls) {
+    return cls == &PyTuple_Type ? 1 : cls == &PyList_Type ? 2 : cls == &PyDict_Type ? 4 : 0;
+}
+
+// Resolves how to walk instances of `cls`, setting *data to a new
+// reference where the kind needs one. -1 on error.
+static int resolve(Walker * self, PyTypeObject * cls, WalkKind * kind, PyObject ** data) {
+    *data = nullptr;
+
+    if (self->handlers) {
+        PyObject * mro = cls->tp_mro;
+
+        for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(mro); i++) {
+            PyObject * handler;
+#if PY_VERSION_HEX >= 0x030D0000
+            if (PyDict_GetItemRef(self->handlers, PyTuple_GET_ITEM(mro, i), &handler) < 0) return -1;
+#else
+            handler = Py_XNewRef(PyDict_GetItemWithError(self->handlers, PyTuple_GET_ITEM(mro, i)));
+            if (!handler && PyErr_Occurred()) return -1;
+#endif
+            if (handler) {
+                *kind = WALK_HANDLER;
+                *data = handler;
+                return 0;
+            }
+        }
+    }
+
+    if (self->gate && gate_matches(self->gate, cls)) {
+        *kind = WALK_LEAF;
+        return 0;
+    }
+
+    // unmatched objects a typed_walker doesn't take apart are left alone
+    *kind = self->gate ? WALK_SKIP : WALK_LEAF;
+
+    if (!self->extended) return 0;
+
+    if (PyType_IsSubtype(cls, &PyTuple_Type)) {
+        *kind = has_attribute(cls, "_fields") && has_attribute(cls, "_make") ? WALK_NAMEDTUPLE : WALK_TUPLE_SUBCLASS;
+    } else if (PyType_IsSubtype(cls, &PyList_Type)) {
+        *kind = WALK_LIST_SUBCLASS;
+    } else if (PyType_IsSubtype(cls, &PyDict_Type)) {
+        *kind = WALK_DICT_SUBCLASS;
+    } else if (PyType_IsSubtype(cls, &PySet_Type) || PyType_IsSubtype(cls, &PyFrozenSet_Type)) {
+        *kind = WALK_SET;
+    } else if (has_attribute(cls, "__dataclass_fields__")) {
+        if (!(*data = dataclass_fields(cls))) return -1;
+        *kind = WALK_ATTRIBUTES;
+    } else if ((*data = slot_names(cls))) {
+        *kind = WALK_ATTRIBUTES;
+    } else if (PyErr_Occurred()) {
+        return -1;
+    }
+    return 0;
+}
+
+static int lookup(Walker * self, PyTypeObject * cls, WalkKind * kind, PyObject ** data) {
+    unsigned int version = type_version_tag(cls);
+
+    if (version && self->types->find(cls, version, kind, data)) return 0;
+
+    if (resolve(self, cls, kind, data) < 0) return -1;
+
+    if (version) self->types->store(cls, version, *kind, *data);
+    return 0;
+}
+
+static PyObject * walk_leaf(Walker * self, PyObject * arg) {
+    PyObject * res = self->func_vectorcall(self->func, &arg, 1, nullptr);
+    assert ((res && !PyErr_Occurred()) || (!res && PyErr_Occurred()));
+    return res;
+}
+
+// A leaf of one of the plain_leaf types, `bit` being its plain_leaf bit.
+static inline PyObject * walk_plain(Walker * self, PyObject * arg, unsigned bit) {
+    return self->plain_skips & bit ? Py_NewRef(arg) : walk_leaf(self, arg);
+}
+
+enum Pending { PENDING_ERROR = -1, PENDING_REWALK, PENDING_CREATED, PENDING_ORIGINAL };
+
+// An empty stand-in for a mutable container reached through a cycle. An
+// immutable one can't be filled later, it is walked again instead, which
+// ends at the mutable container the cycle must pass through. Leaves and
+// handled objects are left as they are.
+static Pending make_pending(Walker * self, PyObject * arg, PyObject ** pending) {
+    PyTypeObject * cls = Py_TYPE(arg);
+
+    if (cls == &PyList_Type) *pending = PyList_New(0);
+    else if (cls == &PyDict_Type) *pending = PyDict_New();
+    else if (cls == &PySet_Type) *pending = PySet_New(nullptr);
+    else if (cls == &PyTuple_Type) return PENDING_REWALK;
+    else if (!self->types) return PENDING_ORIGINAL;
+    else {
+        WalkKind kind;
+        PyObject * data;
+
+        if (lookup(self, cls, &kind, &data) < 0) return PENDING_ERROR;
+        Py_XDECREF(data);
+
+        switch (kind) {
+            case WALK_LIST_SUBCLASS:
+            case WALK_DICT_SUBCLASS:
+            case WALK_SET: {
+                if (PyType_IsSubtype(cls, &PyFrozenSet_Type)) return PENDING_REWALK;
+
+                *pending = shallow_copy(arg);
+                PyObject * cleared = *pending ? PyObject_CallMethod(*pending, "clear", nullptr) : nullptr;
+                if (!cleared) Py_CLEAR(*pending);
+                Py_XDECREF(cleared);
+                break;
+            }
+            case WALK_ATTRIBUTES:
+                *pending = shallow_copy(arg);
+                break;
+            case WALK_TUPLE_SUBCLASS:
+            case WALK_NAMEDTUPLE:
+                return PENDING_REWALK;
+            default:
+                return PENDING_ORIGINAL;
+        }
+    }
+    return *pending ? PENDING_CREATED : PENDING_ERROR;
+}
+
+// Gives the stand-in the contents of the walked container.
+static int fill_pending(Walker * self, PyObject * pending, PyObject * walked) {
+    PyTypeObject * cls = Py_TYPE(pending);
+
+    if (cls == &PyList_Type) return PyList_SetSlice(pending, 0, PyList_GET_SIZE(pending), walked);
+    if (cls == &PyDict_Type) return PyDict_Update(pending, walked);
+
+    if (PyList_Check(pending) || PyDict_Check(pending) || PyAnySet_Check(pending)) {
+        PyObject * result = PyObject_CallMethod(pending, PyList_Check(pending) ? "extend" : "update", "(O)", walked);
+        Py_XDECREF(result);
+        return result ? 0 : -1;
+    }
+
+    WalkKind kind;
+    PyObject * names;
+
+    if (lookup(self, cls, &kind, &names) < 0) return -1;
+
+    for (Py_ssize_t i = 0; names && i < PyTuple_GET_SIZE(names); i++) {
+        PyObject * name = PyTuple_GET_ITEM(names, i);
+        PyObject * value = PyObject_GetAttr(walked, name);
+
+        int status = value ? PyObject_GenericSetAttr(pending, name, value) : -1;
+        Py_XDECREF(value);
+
+        if (status < 0) {
+            if (value || !PyErr_ExceptionMatches(PyExc_AttributeError)) {
+                Py_DECREF(names);
+                return -1;
+            }
+            PyErr_Clear();
+        }
+    }
+    Py_XDECREF(names);
+    return 0;
+}
+
+// The traversal engine. The first levels of plain tuples, lists and dicts
+// are walked recursively, see walk_item; below that, and for every other
+// container, an explicit stack of frames takes over, so nesting depth is
+// bounded by memory alone. Only registered handlers, which call back into
+// the walker, recurse further. The stack's storage is kept by the walker
+// for the next call.
+enum FrameKind {
+    FRAME_TUPLE,    // tuple and tuple subclasses, rebuilt per WalkKind
+    FRAME_LIST,     // exact list, walked in place
+    FRAME_ITEMS,    // snapshot of a set or list subclass's items
+    FRAME_DICT,     // dict and dict subclasses
+    FRAME_ATTRS,    // dataclass fields or slots, items holds the names
+};
+
+struct Frame {
+    PyObject * obj;             // the object being walked, borrowed from the parent's child or the caller
+    PyObject * items;           // the tuple iterated (obj itself for tuples, borrowed), item snapshot or
+                                // attribute names; nullptr for exact dicts
+    PyObject * result;          // the copy, once anything changed
+    PyObject * child;           // the item handed out for walking, kept alive here
+    PyObject * key;             // dict: the current item's key
+    PyObject * new_key;         // dict with keys=True: the walked key
+    Py_ssize_t index;           // next item, or PyDict_Next position
+    Py_ssize_t item_start;      // dict: position of the current item
+    Py_ssize_t size;
+    FrameKind kind;
+    WalkKind walk_kind;
+
+    void release() {
+        if (kind != FRAME_TUPLE) Py_XDECREF(items);
+        Py_XDECREF(result);
+        Py_XDECREF(child);
+        Py_XDECREF(key);
+        Py_XDECREF(new_key);
+    }
+};
+
+// Only the walk that acquired it touches a stack, a walk started from a
+// callback gets another, so references to its frames stay valid for as
+// long as the walk itself pushes nothing.
+struct FrameStack : std::vector<Frame> {};
+
+// State of one walk, resolved once up front.
+struct Walk {
+    Walker * self;
+    FrameStack * frames;    // acquired on first use, see walk_frames
+    WalkMemo * memo;        // nullptr unless preserve_identity
+};
+
+// What entering an object produced when it pushed a frame rather than
+// returning a result.
+static char pushed_marker;
+#define PUSHED ((PyObject *)&pushed_marker)
+
+// The result for `obj` in a preserve_identity walk: a stand-in handed out
+// through a cycle is filled and becomes the result.
+static PyObject * memo_result(Walk & walk, PyObject * obj, PyObject * result) {
+    if (!walk.memo || !result) return result;
+
+    Walker * self = walk.self;
+    auto & entries = walk.memo->entries;
+    auto it = entries.find(obj);
+    PyObject * pending = nullptr;
+
+    if (it != entries.end()) {
+        if (it->second.result) {
+            // walked again further down, through a cycle; that result is shared
+            Py_DECREF(result);
+            return Py_NewRef(it->second.result);
+        }
+        pending = it->second.pending;
+    }
+    if (pending) {
+        // filling runs Python code, which may walk again and grow entries
+        Py_INCREF(pending);
+        int status = fill_pending(self, pending, result);
+        Py_DECREF(result);
+        if (status < 0) {
+            Py_DECREF(pending);
             return nullptr;
+        }
+        result = pending;
+        it = entries.find(obj);
+    }
+    if (it == entries.end()) {
+        it = entries.emplace(Py_NewRef(obj), WalkMemo::Entry {}).first;
+    }
+    Py_XSETREF(it->second.result, Py_NewRef(result));
+    return result;
+}
+
+static PyObject * push(FrameStack & frames, PyObject * obj, FrameKind kind, WalkKind walk_kind, PyObject * items, Py_ssize_t size) {
+    frames.push_back(Frame {obj, items, nullptr, nullptr, nullptr, nullptr, 0, 0, size, kind, walk_kind});
+    return PUSHED;
+}
+
+// Enters `obj`: either walks it right away, returning the result, or
+// pushes a frame for its items and returns PUSHED.
+static PyObject * enter(Walk & walk, PyObject * obj) {
+    Walker * self = walk.self;
+    FrameStack & frames = *walk.frames;
+
+    if (obj == Py_None) return Py_NewRef(Py_None);
+
+    if (walk.memo) {
+        auto & entries = walk.memo->entries;
+        auto it = entries.find(obj);
+
+        if (it == entries.end()) {
+            entries.emplace(Py_NewRef(obj), WalkMemo::Entry {});
+        } else if (it->second.result) {
+            return Py_NewRef(it->second.result);
+        } else if (it->second.pending) {
+            return Py_NewRef(it->second.pending);
         } else {
-            return walk_tuple_from(self, tuple, i, new_elem);
+            // reached again while still being walked
+            PyObject * pending = nullptr;
+
+            switch (make_pending(self, obj, &pending)) {
+                case PENDING_ERROR: return nullptr;
+                case PENDING_ORIGINAL: return Py_NewRef(obj);
+                case PENDING_CREATED:
+                    // entries may have grown meanwhile, look it up again
+                    entries[obj].pending = pending;
+                    return Py_NewRef(pending);
+                case PENDING_REWALK: break;
+            }
         }
     }
-    return Py_NewRef(tuple);
+
+    PyTypeObject * cls = Py_TYPE(obj);
+
+    if (self->leaf_containers && (self->leaf_containers & container_bit(cls))) {
+        return memo_result(walk, obj, walk_leaf(self, obj));
+    }
+
+    if (cls == &PyTuple_Type) {
+        if (!PyTuple_GET_SIZE(obj)) return memo_result(walk, obj, Py_NewRef(obj));
+        return push(frames, obj, FRAME_TUPLE, WALK_LEAF, obj, PyTuple_GET_SIZE(obj));
+    } else if (cls == &PyList_Type) {
+        if (!PyList_GET_SIZE(obj)) return memo_result(walk, obj, Py_NewRef(obj));
+        return push(frames, obj, FRAME_LIST, WALK_LEAF, nullptr, PyList_GET_SIZE(obj));
+    } else if (cls == &PyDict_Type) {
+        if (!PyDict_GET_SIZE(obj)) return memo_result(walk, obj, Py_NewRef(obj));
+        return push(frames, obj, FRAME_DICT, WALK_LEAF, nullptr, 0);
+    }
+
+    // the common leaves skip the lookup unless a handler could claim them
+    unsigned plain = plain_leaf(cls);
+
+    if (!self->types || (!self->handlers && plain)) {
+        return memo_result(walk, obj, walk_plain(self, obj, plain));
+    }
+
+    WalkKind kind;
+    PyObject * data;
+
+    if (lookup(self, cls, &kind, &data) < 0) return nullptr;
+
+    switch (kind) {
+        case WALK_HANDLER: {
+            PyObject * args[] = {obj, self};
+            PyObject * result = PyObject_Vectorcall(data, args, 2, nullptr);
+            Py_DECREF(data);
+            return memo_result(walk, obj, result);
+        }
+        case WALK_TUPLE_SUBCLASS:
+        case WALK_NAMEDTUPLE:
+            return push(frames, obj, FRAME_TUPLE, kind, obj, PyTuple_GET_SIZE(obj));
+        case WALK_LIST_SUBCLASS:
+        case WALK_SET: {
+            PyObject * items = kind == WALK_SET ? PySequence_Tuple(obj) : PyList_AsTuple(obj);
+            return items ? push(frames, obj, FRAME_ITEMS, kind, items, PyTuple_GET_SIZE(items)) : nullptr;
+        }
+        case WALK_DICT_SUBCLASS: {
+            // through items(), in the subclass's own order
+            PyObject * view = PyObject_CallMethod(obj, "items", nullptr);
+            PyObject * items = view ? PySequence_Tuple(view) : nullptr;
+            Py_XDECREF(view);
+            return items ? push(frames, obj, FRAME_DICT, kind, items, PyTuple_GET_SIZE(items)) : nullptr;
+        }
+        case WALK_ATTRIBUTES:
+            return push(frames, obj, FRAME_ATTRS, kind, data, PyTuple_GET_SIZE(data));
+        case WALK_SKIP:
+            return memo_result(walk, obj, Py_NewRef(obj));
+        default:
+            return memo_result(walk, obj, walk_leaf(self, obj));
+    }
 }
 
-static PyObject * walk_list_from(Walker * self, PyObject * list, size_t from, PyObject * new_element) {
-    size_t n = PyList_GET_SIZE(list);
+static bool next_dict_item(Frame & f, PyObject ** key, PyObject ** value) {
+    if (!f.items) return PyDict_Next(f.obj, &f.index, key, value);
+    if (f.index >= f.size) return false;
 
-    PyObject * new_list = PyList_New(n);
-    if (!new_list) return nullptr;
+    PyObject * item = PyTuple_GET_ITEM(f.items, f.index++);
 
-    for (size_t j = 0; j < from; ++j) {
-        PyList_SET_ITEM(new_list, j, Py_NewRef(PyList_GET_ITEM(list, j)));
+    if (!PyTuple_Check(item) || PyTuple_GET_SIZE(item) != 2) {
+        PyErr_Format(PyExc_TypeError, "%s.items() must give key, value pairs", Py_TYPE(f.obj)->tp_name);
+        return false;
     }
-    PyList_SET_ITEM(new_list, from, new_element);
-    
-    for (size_t i = from + 1; i < n; ++i) {
-        PyObject * elem = PyList_GET_ITEM(list, i);
-        PyObject * new_elem = walk(self, elem);
+    *key = PyTuple_GET_ITEM(item, 0);
+    *value = PyTuple_GET_ITEM(item, 1);
+    return true;
+}
+
+// Hands out the top frame's next item to walk in *child, borrowed from the
+// frame: 1 when there is one, 0 when the frame is done, -1 on error.
+static int next_child(Walker * self, Frame & f, PyObject ** child) {
+    switch (f.kind) {
+        case FRAME_TUPLE:
+        case FRAME_ITEMS:
+            if (f.index >= f.size) return 0;
+            f.child = Py_NewRef(PyTuple_GET_ITEM(f.items, f.index));
+            break;
+
+        case FRAME_LIST:
+            if (f.index >= f.size) return 0;
+            if (f.index >= PyList_GET_SIZE(f.obj)) {
+                PyErr_SetString(PyExc_RuntimeError, "list changed size during walk");
+                return -1;
+            }
+            f.child = Py_NewRef(PyList_GET_ITEM(f.obj, f.index));
+            break;
+
+        case FRAME_DICT:
+            if (f.key) {
+                // the key is walked, now the value
+                *child = f.child;
+                return 1;
+            } else {
+                PyObject *key, *value;
+                f.item_start = f.index;
+
+                if (!next_dict_item(f, &key, &value)) return PyErr_Occurred() ? -1 : 0;
+
+                f.key = Py_NewRef(key);
+                f.child = Py_NewRef(value);
+
+                // with keys=True the key goes first, new_key stays unset until it's back
+                *child = self->keys ? f.key : f.child;
+                return 1;
+            }
+
+        case FRAME_ATTRS:
+            for (; f.index < f.size; f.index++) {
+                PyObject * value = PyObject_GetAttr(f.obj, PyTuple_GET_ITEM(f.items, f.index));
+
+                if (value) {
+                    *child = f.child = value;
+                    return 1;
+                }
+                if (!PyErr_ExceptionMatches(PyExc_AttributeError)) return -1;
+                PyErr_Clear();          // unset slot
+            }
+            return 0;
+    }
+    *child = f.child;
+    return 1;
+}
+
+// Re-inserts the dict items before the current one into an empty copy,
+// for a dict whose keys are walked.
+static int copy_dict_prefix(Frame & f) {
+    Py_ssize_t end = f.item_start;
+    Py_ssize_t pos = 0;
+    PyObject *key, *value;
+
+    if (f.items) {
+        for (; pos < end; pos++) {
+            PyObject * item = PyTuple_GET_ITEM(f.items, pos);
+            if (set_item(f.result, PyTuple_GET_ITEM(item, 0), PyTuple_GET_ITEM(item, 1)) < 0) return -1;
+        }
+        return 0;
+    }
+    while (pos < end && PyDict_Next(f.obj, &pos, &key, &value)) {
+        if (set_item(f.result, key, value) < 0) return -1;
+    }
+    return 0;
+}
+
+static int accept_dict(Walker * self, Frame & f, PyObject * walked) {
+    if (self->keys && !f.new_key) {
+        f.new_key = walked;
+        return 0;
+    }
+
+    PyObject * key = f.new_key ? f.new_key : f.key;
+    bool changed = key != f.key || walked != f.child;
+    int status = 0;
+
+    if (!f.result && changed) {
+        // with keys walked a changed key can't be replaced in place, the
+        // dict is rebuilt in order
+        f.result = copy_dict(f.obj, self->keys);
+        status = !f.result ? -1 : self->keys ? copy_dict_prefix(f) : 0;
+    }
+    if (status == 0 && f.result && (self->keys || changed)) {
+        status = set_item(f.result, key, walked);
+    }
+    Py_DECREF(walked);
+    Py_CLEAR(f.key);
+    Py_CLEAR(f.new_key);
+    Py_CLEAR(f.child);
+    return status;
+}
+
+// Takes the walked result of the top frame's current item.
+static int accept(Walker * self, Frame & f, PyObject * walked) {
+    if (f.kind == FRAME_DICT) return accept_dict(self, f, walked);
+
+    Py_ssize_t i = f.index++;
+    PyObject * child = f.child;
+    f.child = nullptr;
+    Py_DECREF(child);           // only compared by address from here
+
+    if (f.kind == FRAME_LIST && PyList_GET_SIZE(f.obj) < i) {
+        // the prefix a copy takes is gone
+        PyErr_SetString(PyExc_RuntimeError, "list changed size during walk");
+        Py_DECREF(walked);
+        return -1;
+    }
+
+    if (f.result) {
+        if (f.kind == FRAME_LIST) PyList_SET_ITEM(f.result, i, walked);
+        else if (f.kind == FRAME_ATTRS) goto set_attribute;
+        else PyTuple_SET_ITEM(f.result, i, walked);
+        return 0;
+    }
+    if (walked == child) {
+        Py_DECREF(walked);
+        return 0;
+    }
+
+    switch (f.kind) {
+        case FRAME_LIST:
+            if (!(f.result = PyList_New(f.size))) break;
+
+            for (Py_ssize_t j = 0; j < i; j++) {
+                PyList_SET_ITEM(f.result, j, Py_NewRef(PyList_GET_ITEM(f.obj, j)));
+            }
+            PyList_SET_ITEM(f.result, i, walked);
+            return 0;
+
+        case FRAME_ATTRS:
+            if (!(f.result = shallow_copy(f.obj))) break;
+            goto set_attribute;
+
+        default:
+            if (!(f.result = PyTuple_New(f.size))) break;
 
-        if (!new_elem) {
-            Py_DECREF(new_list);
+            for (Py_ssize_t j = 0; j < i; j++) {
+                PyTuple_SET_ITEM(f.result, j, Py_NewRef(PyTuple_GET_ITEM(f.items, j)));
+            }
+            PyTuple_SET_ITEM(f.result, i, walked);
+            return 0;
+    }
+    Py_DECREF(walked);
+    return -1;
+
+set_attribute: {
+        // object.__setattr__, so frozen dataclasses take it too
+        int status = PyObject_GenericSetAttr(f.result, PyTuple_GET_ITEM(f.items, i), walked);
+        Py_DECREF(walked);
+        return status;
+    }
+}
+
+// The walked result of a finished frame.
+static PyObject * rebuild(Frame & f) {
+    if (!f.result) return Py_NewRef(f.obj);
+
+    PyTypeObject * cls = Py_TYPE(f.obj);
+
+    switch (f.walk_kind) {
+        case WALK_NAMEDTUPLE:
+            return PyObject_CallMethod((PyObject *)cls, "_make", "(O)", f.result);
+        case WALK_TUPLE_SUBCLASS:
+        case WALK_LIST_SUBCLASS:
+            return PyObject_CallOneArg((PyObject *)cls, f.result);
+        case WALK_SET:
+            return cls == &PySet_Type ? PySet_New(f.result)
+                 : cls == &PyFrozenSet_Type ? PyFrozenSet_New(f.result)
+                 : PyObject_CallOneArg((PyObject *)cls, f.result);
+        default:
+            return Py_NewRef(f.result);
+    }
+}
+
+// The walker's spare frame stack, or a new one when a walk of the same
+// walker is already running (nested in a handler, or on another thread).
+static FrameStack * acquire_frames(Walker * self) {
+    FrameStack * frames;
+
+    Py_BEGIN_CRITICAL_SECTION(self);
+    frames = self->spare_frames;
+    self->spare_frames = nullptr;
+    Py_END_CRITICAL_SECTION();
+
+    return frames ? frames : new FrameStack();
+}
+
+static void release_frames(Walker * self, FrameStack * frames) {
+    Py_BEGIN_CRITICAL_SECTION(self);
+    if (!self->spare_frames) std::swap(self->spare_frames, frames);
+    Py_END_CRITICAL_SECTION();
+
+    delete frames;
+}
+
+static PyObject * walk_frames(Walk & walk, PyObject * arg) {
+    if (!walk.frames) walk.frames = acquire_frames(walk.self);
+
+    FrameStack & frames = *walk.frames;
+
+    PyObject * child = arg;
+    PyObject * result;
+
+    for (;;) {
+        result = enter(walk, child);
+
+        if (!result) goto error;
+
+        if (result != PUSHED) {
+            if (!frames.size()) return result;
+            if (accept(walk.self, frames.back(), result) < 0) goto error;
+        }
+
+        for (;;) {
+            Frame & top = frames.back();
+            int status = next_child(walk.self, top, &child);
+
+            if (status < 0) goto error;
+
+            if (status > 0) {
+                // plain leaves are walked on the spot, without entering them
+                unsigned plain = plain_leaf(Py_TYPE(child));
+
+                if (walk.memo || walk.self->handlers || !plain) break;
+
+                if (!(result = walk_plain(walk.self, child, plain)) || accept(walk.self, top, result) < 0) goto error;
+                continue;
+            }
+
+            // frame finished: pop it and hand its result to the parent
+            result = memo_result(walk, top.obj, rebuild(top));
+            top.release();
+            frames.pop_back();
+
+            if (!result) goto error;
+            if (!frames.size()) return result;
+            if (accept(walk.self, frames.back(), result) < 0) goto error;
+        }
+    }
+
+error:
+    while (frames.size()) {
+        frames.back().release();
+        frames.pop_back();
+    }
+    return nullptr;
+}
+
+// Plain tuples, lists and dicts this many levels deep are walked by C
+// recursion: most inputs are shallow, and a call per container is cheaper
+// than pushing a frame. Anything deeper goes to the frame stack. walk_item
+// is inlined into the container loops, which stay out of line themselves
+// so the inlining doesn't cascade.
+static constexpr int recursion_limit = 32;
+
+static inline PyObject * walk_item(Walk & walk, PyObject * obj, int depth);
+
+NOINLINE static PyObject * walk_tuple(Walk & walk, PyObject * tuple, int depth) {
+    Py_ssize_t n = PyTuple_GET_SIZE(tuple);
+    PyObject * result = nullptr;
+
+    for (Py_ssize_t i = 0; i < n; i++) {
+        PyObject * item = PyTuple_GET_ITEM(tuple, i);
+        PyObject * walked = walk_item(walk, item, depth);
+
+        if (!walked) {
+            Py_XDECREF(result);
             return nullptr;
         }
-        PyList_SET_ITEM(new_list, i, new_elem);
+        if (!result) {
+            if (walked == item) {
+                Py_DECREF(walked);
+                continue;
+            }
+            if (!(result = PyTuple_New(n))) {
+                Py_DECREF(walked);
+                return nullptr;
+            }
+            for (Py_ssize_t j = 0; j < i; j++) {
+                PyTuple_SET_ITEM(result, j, Py_NewRef(PyTuple_GET_ITEM(tuple, j)));
+            }
+        }
+        PyTuple_SET_ITEM(result, i, walked);
     }
-    return new_list;
+    return result ? result : Py_NewRef(tuple);
 }
 
-static PyObject * walk_list(Walker * self, PyObject * list) {
-    size_t n = PyList_GET_SIZE(list);
+NOINLINE static PyObject * walk_list(Walk & walk, PyObject * list, int depth) {
+    Py_ssize_t n = PyList_GET_SIZE(list);
+    PyObject * result = nullptr;
 
-    for (size_t i = 0; i < n; ++i) {
-        PyObject * elem = PyList_GET_ITEM(list, i);
-        PyObject * new_elem = walk(self, elem);
-        
-        if (elem == new_elem) {
-            Py_DECREF(new_elem);
-        } else if (!new_elem) {
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (i >= PyList_GET_SIZE(list)) {
+            PyErr_SetString(PyExc_RuntimeError, "list changed size during walk");
+            Py_XDECREF(result);
             return nullptr;
-        } else {
-            return walk_list_from(self, list, i, new_elem);
         }
+        PyObject * item = Py_NewRef(PyList_GET_ITEM(list, i));
+        PyObject * walked = walk_item(walk, item, depth);
+        Py_DECREF(item);            // only compared by address from here
+
+        if (walked && PyList_GET_SIZE(list) < i) {
+            // the prefix copied below is gone
+            PyErr_SetString(PyExc_RuntimeError, "list changed size during walk");
+            Py_CLEAR(walked);
+        }
+        if (!walked) {
+            Py_XDECREF(result);
+            return nullptr;
+        }
+        if (!result) {
+            if (walked == item) {
+                Py_DECREF(walked);
+                continue;
+            }
+            if (!(result = PyList_New(n))) {
+                Py_DECREF(walked);
+                return nullptr;
+            }
+            for (Py_ssize_t j = 0; j < i; j++) {
+                PyList_SET_ITEM(result, j, Py_NewRef(PyList_GET_ITEM(list, j)));
+            }
+        }
+        PyList_SET_ITEM(result, i, walked);
     }
-    return Py_NewRef(list); 
+    return result ? result : Py_NewRef(list);
 }
 
-static PyObject * walk_dict(Walker * self, PyObject * dict) {
+// An exact dict whose keys are left alone.
+NOINLINE static PyObject * walk_dict(Walk & walk, PyObject * dict, int depth) {
     Py_ssize_t pos = 0;
     PyObject *key, *value;
+    PyObject * result = nullptr;
 
     while (PyDict_Next(dict, &pos, &key, &value)) {
-        PyObject * new_value = walk(self, value);
+        Py_INCREF(key);
+        Py_INCREF(value);
 
-        if (new_value == value) {
-            Py_DECREF(value);
-        } else if (!new_value) {
-            return nullptr;
-        } else {
-            PyObject * new_dict = PyDict_Copy(dict);
+        PyObject * walked = walk_item(walk, value, depth);
+        int status = walked ? 0 : -1;
 
-            PyDict_SetItem(new_dict, key, new_value);
-            Py_DECREF(new_value);
+        if (walked && walked != value) {
+            if (!result && !(result = PyDict_Copy(dict))) status = -1;
+            else status = PyDict_SetItem(result, key, walked);
+        }
+        Py_XDECREF(walked);
+        Py_DECREF(key);
+        Py_DECREF(value);
 
-            while (PyDict_Next(dict, &pos, &key, &value)) {
-                new_value = walk(self, value);
-                if (!new_value) {
-                    Py_DECREF(new_dict);
-                    return nullptr;
-                }
-                PyDict_SetItem(new_dict, key, new_value);
-                Py_DECREF(new_value);
-            }
-            return new_dict;
+        if (status < 0) {
+            Py_XDECREF(result);
+            return nullptr;
         }
     }
-    return Py_NewRef(dict);
+    return result ? result : Py_NewRef(dict);
+}
+
+// Walks `obj`, found `depth` containers down: plain leaves and shallow
+// plain containers right here, everything else on the frame stack.
+ALWAYS_INLINE static PyObject * walk_item(Walk & walk, PyObject * obj, int depth) {
+    if (obj == Py_None) return Py_NewRef(Py_None);
+
+    Walker * self = walk.self;
+    PyTypeObject * cls = Py_TYPE(obj);
+
+    if (cls == &PyTuple_Type) {
+        if (self->leaf_containers & 1) return walk_leaf(self, obj);
+        if (!PyTuple_GET_SIZE(obj)) return Py_NewRef(obj);
+        if (depth < recursion_limit) return walk_tuple(walk, obj, depth + 1);
+    } else if (cls == &PyList_Type) {
+        if (self->leaf_containers & 2) return walk_leaf(self, obj);
+        if (!PyList_GET_SIZE(obj)) return Py_NewRef(obj);
+        if (depth < recursion_limit) return walk_list(walk, obj, depth + 1);
+    } else if (cls == &PyDict_Type) {
+        if (self->leaf_containers & 4) return walk_leaf(self, obj);
+        if (!PyDict_GET_SIZE(obj)) return Py_NewRef(obj);
+        if (depth < recursion_limit && !self->keys) return walk_dict(walk, obj, depth + 1);
+    } else if (!self->types) {
+        return walk_leaf(self, obj);
+    } else {
+        unsigned plain = plain_leaf(cls);
+
+        if (plain && !self->handlers) return walk_plain(self, obj, plain);
+    }
+    return walk_frames(walk, obj);
 }
 
 static PyObject * walk(Walker * self, PyObject * arg) {
@@ -132,20 +1014,214 @@ static PyObject * walk(Walker * self, PyObject * arg) {
 
     if (arg == Py_None) return Py_NewRef(Py_None);
 
+    Walk state = {self, nullptr, self->preserve_identity ? WalkMemo::active : nullptr};
+
+    // the memo records every object on its way through enter
+    PyObject * result = state.memo ? walk_frames(state, arg) : walk_item(state, arg, 0);
+
+    if (state.frames) release_frames(self, state.frames);
+    return result;
+}
+
+// A top-level preserve_identity walk, run with a fresh memo; nested calls
+// from within it share the memo.
+static PyObject * walk_root(Walker * self, PyObject * arg) {
+    WalkMemo * outer = WalkMemo::active;
+
+    if (outer && outer->walker == self) return walk(self, arg);
+
+    static thread_local WalkMemo spare;
+    WalkMemo local;
+
+    WalkMemo * memo = spare.walker ? &local : &spare;
+    memo->walker = self;
+    WalkMemo::active = memo;
+
+    PyObject * result = walk(self, arg);
+
+    WalkMemo::active = outer;
+    memo->reset();
+    return result;
+}
+
+// Splitting a walk across threads. Only free-threaded builds gain from it,
+// under the GIL the workers would just take turns; build with
+// -DPARALLEL_WALK=1 to run the threaded path there anyway, for testing.
+#ifndef PARALLEL_WALK
+#ifdef Py_GIL_DISABLED
+#define PARALLEL_WALK 1
+#else
+#define PARALLEL_WALK 0
+#endif
+#endif
+
+#if PARALLEL_WALK
+
+// A top-level container is split once it holds this many items, and
+// workers take them a chunk at a time.
+static constexpr Py_ssize_t parallel_threshold = 4096;
+static constexpr Py_ssize_t parallel_chunk = 256;
+
+// Set on the threads of a split walk: walks started from handlers there
+// stay sequential.
+static thread_local bool in_parallel_walk = false;
+
+// The items of one split walk. Threads claim chunks from a shared counter,
+// so one that finishes early simply takes more, and results land by index,
+// so the output doesn't depend on scheduling.
+struct ParallelWalk {
+    Walker * self;
+    std::vector<PyObject *> items;      // borrowed from the snapshot
+    std::vector<PyObject *> results;    // new references, nullptr until walked
+    std::atomic<size_t> next {0};
+    std::atomic<bool> failed {false};
+    std::mutex lock;
+    PyObject * error = nullptr;         // the first exception raised, under lock
+
+    void fail() {
+        PyObject * raised = fetch_error();
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!error) std::swap(error, raised);
+        }
+        failed = true;
+        Py_XDECREF(raised);             // a later error, dropped
+    }
+
+    void run() {
+        FrameStack frames;
+        Walk walk = {self, &frames, nullptr};
+
+        in_parallel_walk = true;
+
+        while (!failed.load(std::memory_order_relaxed)) {
+            size_t start = next.fetch_add(parallel_chunk);
+            if (start >= items.size()) break;
+
+            size_t end = std::min(start + parallel_chunk, items.size());
+
+            for (size_t i = start; i < end; i++) {
+                if (!(results[i] = walk_item(walk, items[i], 1))) {
+                    fail();
+                    break;
+                }
+            }
+        }
+        in_parallel_walk = false;
+    }
+
+    ~ParallelWalk() {
+        for (PyObject * result : results) Py_XDECREF(result);
+    }
+};
+
+static void parallel_worker(ParallelWalk * work) {
+    PyGILState_STATE state = PyGILState_Ensure();
+    work->run();
+    PyGILState_Release(state);
+}
+
+// Puts the walked items back together, copy-on-write like a sequential
+// walk; takes the results.
+static PyObject * stitch(PyObject * arg, PyObject * snapshot, ParallelWalk & work) {
+    size_t n = work.items.size();
+    bool changed = false;
+
+    for (size_t i = 0; i < n && !changed; i++) changed = work.results[i] != work.items[i];
+
+    if (!changed) return Py_NewRef(arg);
+
+    if (PyDict_CheckExact(arg)) {
+        PyObject * result = PyDict_New();
+        size_t step = work.self->keys ? 2 : 1;
+
+        for (size_t i = 0; result && i < n; i += step) {
+            PyObject * pair = PyList_GET_ITEM(snapshot, i / step);
+            PyObject * key = work.self->keys ? work.results[i] : PyTuple_GET_ITEM(pair, 0);
+
+            if (PyDict_SetItem(result, key, work.results[i + step - 1]) < 0) Py_CLEAR(result);
+        }
+        return result;
+    }
+    PyObject * result = PyList_CheckExact(arg) ? PyList_New(n) : PyTuple_New(n);
+
+    for (size_t i = 0; result && i < n; i++) {
+        PyObject * item = work.results[i];
+        work.results[i] = nullptr;
+
+        if (PyList_CheckExact(result)) PyList_SET_ITEM(result, i, item);
+        else PyTuple_SET_ITEM(result, i, item);
+    }
+    return result;
+}
+
+// Walks the items of a large list, tuple or dict on up to self->parallel
+// threads, this one included.
+static PyObject * walk_split(Walker * self, PyObject * arg) {
     PyTypeObject * cls = Py_TYPE(arg);
 
-    if (cls == &PyTuple_Type) {
-        return walk_tuple(self, arg);
-    } else if (cls == &PyList_Type) {
-        return walk_list(self, arg);
-    } else if (cls == &PyDict_Type) {
-        return walk_dict(self, arg);
+    // a snapshot, so the items stay put whatever happens to the input meanwhile
+    PyObject * snapshot = cls == &PyDict_Type ? PyDict_Items(arg) : cls == &PyList_Type ? PyList_AsTuple(arg) : Py_NewRef(arg);
+    if (!snapshot) return nullptr;
+
+    ParallelWalk work;
+    work.self = self;
+
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(snapshot); i++) {
+        PyObject * item = PySequence_Fast_GET_ITEM(snapshot, i);
+
+        if (cls == &PyDict_Type) {
+            if (self->keys) work.items.push_back(PyTuple_GET_ITEM(item, 0));
+            work.items.push_back(PyTuple_GET_ITEM(item, 1));
+        } else {
+            work.items.push_back(item);
+        }
+    }
+    work.results.assign(work.items.size(), nullptr);
+
+    size_t chunks = (work.items.size() + parallel_chunk - 1) / parallel_chunk;
+    size_t nthreads = std::min((size_t)self->parallel, chunks);
+    std::vector<std::thread> threads;
+
+    try {
+        while (threads.size() + 1 < nthreads) threads.emplace_back(parallel_worker, &work);
+    } catch (std::system_error &) {
+        // fewer threads then, the rest of the work is done here
+    }
+    work.run();
+
+    Py_BEGIN_ALLOW_THREADS
+    for (std::thread & thread : threads) thread.join();
+    Py_END_ALLOW_THREADS
+
+    PyObject * result;
+
+    if (work.failed) {
+        restore_error(work.error);
+        result = nullptr;
     } else {
-        PyObject * res = self->func_vectorcall(self->func, &arg, 1, nullptr);
-        assert ((res && !PyErr_Occurred()) || (!res && PyErr_Occurred()));
-        return res;
-        // return self->func_vectorcall(self->func, &arg, 1, nullptr);
+        result = stitch(arg, snapshot, work);
+    }
+    Py_DECREF(snapshot);
+    return result;
+}
+
+#endif
+
+// A walk of self->parallel > 1: a large exact list, tuple or dict at the
+// top is split across threads, anything else is walked as usual.
+static PyObject * walk_parallel(Walker * self, PyObject * arg) {
+#if PARALLEL_WALK
+    PyTypeObject * cls = Py_TYPE(arg);
+    Py_ssize_t size = cls == &PyList_Type ? PyList_GET_SIZE(arg) :
+                      cls == &PyTuple_Type ? PyTuple_GET_SIZE(arg) :
+                      cls == &PyDict_Type ? PyDict_GET_SIZE(arg) : 0;
+
+    if (size >= parallel_threshold && !in_parallel_walk && !(self->leaf_containers & container_bit(cls))) {
+        return walk_split(self, arg);
     }
+#endif
+    return walk(self, arg);
 }
 
 static PyObject * call(Walker * self, PyObject* const * args, size_t nargsf, PyObject* kwnames) {
@@ -164,46 +1240,169 @@ static PyObject * call(Walker * self, PyObject* const * args, size_t nargsf, PyO
             return nullptr;
         }
     }
-    return walk(self, args[0]);
+    if (self->preserve_identity) return walk_root(self, args[0]);
+
+    return self->parallel > 1 ? walk_parallel(self, args[0]) : walk(self, args[0]);
 }
 
 static int traverse(Walker* self, visitproc visit, void* arg) {
     Py_VISIT(self->func);
+    Py_VISIT(self->handlers);
+    Py_VISIT(self->gate);
 
+    if (self->types) {
+        for (auto & [type, entry] : self->types->entries) Py_VISIT(entry.data);
+    }
     return 0;
 }
 
 static int clear(Walker* self) {
     Py_CLEAR(self->func);
+    Py_CLEAR(self->handlers);
+    Py_CLEAR(self->gate);
+    if (self->types) self->types->clear();
     return 0;
 }
 
 static void dealloc(Walker *self) {
     PyObject_GC_UnTrack(self);          // Untrack from the GC
     clear(self);
+    delete self->types;
+    delete self->spare_frames;
     Py_TYPE(self)->tp_free((PyObject *)self);  // Free the object
 }
 
-static int init(Walker *self, PyObject *args, PyObject *kwds) {
+static PyObject * register_handler(Walker * self, PyObject * const * args, Py_ssize_t nargs) {
+    if (nargs != 2) {
+        PyErr_Format(PyExc_TypeError, "register() takes exactly 2 arguments (%zd given)", nargs);
+        return nullptr;
+    }
+    if (!PyType_Check(args[0])) {
+        PyErr_Format(PyExc_TypeError, "register() expects a type, got %S", Py_TYPE(args[0]));
+        return nullptr;
+    }
+    if (!PyCallable_Check(args[1])) {
+        PyErr_Format(PyExc_TypeError, "register() expects a callable handler, got %S", Py_TYPE(args[1]));
+        return nullptr;
+    }
+    if (!self->handlers && !(self->handlers = PyDict_New())) return nullptr;
 
-    PyObject * function = NULL;
+    if (PyDict_SetItem(self->handlers, args[0], args[1]) < 0) return nullptr;
 
-    static const char *kwlist[] = { "function", NULL};
+    if (!self->types) self->types = new WalkerTypes();
+    else self->types->clear();
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", (char **)kwlist, &function))
-    {
-        return -1; // Return NULL on failure
-    }
+    Py_RETURN_NONE;
+}
 
+// The setup shared by walker and typed_walker, once the gate is in place.
+static int setup(Walker * self, PyObject * function, int extended, int keys, int preserve_identity, Py_ssize_t parallel) {
     CHECK_CALLABLE(function);
+
+    if (parallel < 1) {
+        PyErr_Format(PyExc_ValueError, "parallel must be at least 1, not %zd", parallel);
+        return -1;
+    }
     
-    self->func = Py_XNewRef(function);
+    Py_XSETREF(self->func, Py_XNewRef(function));
     self->func_vectorcall = extract_vectorcall(function);
     self->vectorcall = (vectorcallfunc)call;
+    self->extended = extended;
+    self->keys = keys;
+    self->preserve_identity = preserve_identity;
+    self->parallel = parallel;
+
+    if (self->types) self->types->clear();
+    else if (extended || self->handlers || self->gate) self->types = new WalkerTypes();
 
     return 0;
 }
 
+static int init(Walker *self, PyObject *args, PyObject *kwds) {
+
+    PyObject * function = NULL;
+    int extended = 0;
+    int keys = 0;
+    int preserve_identity = 0;
+    Py_ssize_t parallel = 1;
+
+    static const char *kwlist[] = { "function", "extended", "keys", "preserve_identity", "parallel", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|$pppn", (char **)kwlist, &function, &extended, &keys, &preserve_identity, &parallel))
+    {
+        return -1; // Return NULL on failure
+    }
+    return setup(self, function, extended, keys, preserve_identity, parallel);
+}
+
+// A typed_walker's gate: the given types as a tuple, or an isinstanceof or
+// TypePredicate predicate as it is.
+static PyObject * make_gate(PyObject * types) {
+    if (PyType_Check(types)) return PyTuple_Pack(1, types);
+
+    if (PyTuple_Check(types) || PyList_Check(types) || PyAnySet_Check(types)) {
+        PyObject * gate = PySequence_Tuple(types);
+
+        for (Py_ssize_t i = 0; gate && i < PyTuple_GET_SIZE(gate); i++) {
+            if (!PyType_Check(PyTuple_GET_ITEM(gate, i))) {
+                PyErr_Format(PyExc_TypeError, "typed_walker() expects types, got %S", Py_TYPE(PyTuple_GET_ITEM(gate, i)));
+                Py_CLEAR(gate);
+            }
+        }
+        return gate;
+    }
+    if (type_test(types, &PyBaseObject_Type) >= 0) return Py_NewRef(types);
+
+    PyErr_Format(PyExc_TypeError, "typed_walker() expects a type, a collection of types or an isinstanceof predicate, got %S", Py_TYPE(types));
+    return nullptr;
+}
+
+static int typed_init(Walker *self, PyObject *args, PyObject *kwds) {
+
+    PyObject * types = NULL;
+    PyObject * function = NULL;
+    int extended = 0;
+    int keys = 0;
+    int preserve_identity = 0;
+    Py_ssize_t parallel = 1;
+
+    static const char *kwlist[] = { "types", "function", "extended", "keys", "preserve_identity", "parallel", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|$pppn", (char **)kwlist, &types, &function, &extended, &keys, &preserve_identity, &parallel))
+    {
+        return -1;
+    }
+    PyObject * gate = make_gate(types);
+    if (!gate) return -1;
+
+    Py_XSETREF(self->gate, gate);
+
+    // the builtins are never looked up, settle them now
+    static PyTypeObject * const plain[] = {&PyLong_Type, &PyUnicode_Type, &PyFloat_Type, &PyBool_Type, &PyBytes_Type};
+    static PyTypeObject * const containers[] = {&PyTuple_Type, &PyList_Type, &PyDict_Type};
+
+    self->plain_skips = 0;
+    for (PyTypeObject * cls : plain) {
+        if (!gate_matches(gate, cls)) self->plain_skips |= plain_leaf(cls);
+    }
+    self->leaf_containers = 0;
+    for (PyTypeObject * cls : containers) {
+        if (gate_matches(gate, cls)) self->leaf_containers |= container_bit(cls);
+    }
+    return setup(self, function, extended, keys, preserve_identity, parallel);
+}
+
+static PyMethodDef methods[] = {
+    {"register", (PyCFunction)register_handler, METH_FASTCALL,
+     "register(cls, handler)\n--\n\n"
+     "Walk instances of cls, and its subclasses, with handler(obj, walker).\n\n"
+     "The handler returns the replacement for obj, or obj itself when nothing\n"
+     "changed, and calls walker on the parts it wants walked. Registered\n"
+     "handlers take precedence over the built-in ones, except for exact\n"
+     "tuples, lists and dicts."},
+    {NULL}  // Sentinel
+};
+
 static PyMemberDef members[] = {
     // {"on_call", T_OBJECT, OFFSET_OF_MEMBER(Observer, on_call), READONLY, "TODO"},
     // {"on_result", T_OBJECT, OFFSET_OF_MEMBER(Observer, on_result), READONLY, "TODO"},
@@ -221,13 +1420,29 @@ PyTypeObject Walker_Type = {
     .tp_vectorcall_offset = OFFSET_OF_MEMBER(Walker, vectorcall),
     .tp_call = PyVectorcall_Call,
     .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_HAVE_VECTORCALL,
-    .tp_doc = "walker(function)\n--\n\n"
+    .tp_doc = "walker(function, *, extended=False, keys=False, preserve_identity=False, parallel=1)\n--\n\n"
                "Recursively walk and transform nested data structures.\n\n"
                "Traverses tuples, lists, and dicts, applying function to\n"
                "leaf values (non-container types). Preserves structure and\n"
-               "uses copy-on-write for efficiency.\n\n"
+               "uses copy-on-write for efficiency: a container comes back\n"
+               "as the same object unless something inside it changed.\n\n"
+               "With extended=True sets, frozensets, namedtuples and other tuple,\n"
+               "list and dict subclasses, dataclasses and __slots__ objects are\n"
+               "walked too, rebuilt as the same type. Further types can be given\n"
+               "handlers with register(). How each type is walked is resolved once\n"
+               "and cached.\n\n"
                "Args:\n"
-               "    function: Transform to apply to leaf values.\n\n"
+               "    function: Transform to apply to leaf values.\n"
+               "    extended: Also walk the containers listed above.\n"
+               "    keys: Also walk dict keys.\n"
+               "    preserve_identity: Walk each object once per call, so objects\n"
+               "        shared in the input are shared in the output, and rebuild\n"
+               "        reference cycles instead of recursing forever.\n"
+               "    parallel: On free-threaded builds, split a large list, tuple or\n"
+               "        dict given to the walker across up to this many threads,\n"
+               "        which then call function concurrently. The result is the\n"
+               "        same as walking sequentially, which is what happens with the\n"
+               "        GIL and with preserve_identity.\n\n"
                "Returns:\n"
                "    A callable that walks and transforms nested structures.\n\n"
                "Example:\n"
@@ -235,8 +1450,39 @@ PyTypeObject Walker_Type = {
                "    >>> double({'a': [1, 2], 'b': 3})  # {'a': [2, 4], 'b': 6}",
     .tp_traverse = (traverseproc)traverse,
     .tp_clear = (inquiry)clear,
-    // .tp_methods = methods,
+    .tp_methods = methods,
     .tp_members = members,
     .tp_init = (initproc)init,
     .tp_new = PyType_GenericNew,
 };
+
+PyTypeObject TypePredWalker_Type = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = MODULE "typed_walker",
+    .tp_basicsize = sizeof(Walker),
+    .tp_itemsize = 0,
+    .tp_dealloc = (destructor)dealloc,
+    .tp_vectorcall_offset = OFFSET_OF_MEMBER(Walker, vectorcall),
+    .tp_call = PyVectorcall_Call,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC | Py_TPFLAGS_HAVE_VECTORCALL,
+    .tp_doc = "typed_walker(types, function, *, extended=False, keys=False, preserve_identity=False, parallel=1)\n--\n\n"
+               "A walker that applies function only to objects of the given types.\n\n"
+               "Containers are walked as by walker, but anything else that doesn't\n"
+               "match is returned as it is, without calling function. A matching\n"
+               "container is passed to function rather than walked. Whether a type\n"
+               "matches is worked out once and cached, so a payload of unmatched\n"
+               "leaves costs a type check per item and comes back by reference.\n\n"
+               "Args:\n"
+               "    types: A type, a collection of types, or an isinstanceof or\n"
+               "        TypePredicate predicate. Subclasses of the types match.\n"
+               "    function: Transform to apply to matching objects.\n"
+               "    extended, keys, preserve_identity, parallel: As for walker.\n\n"
+               "Example:\n"
+               "    >>> upper = typed_walker(str, str.upper)\n"
+               "    >>> upper({'a': ['x', 1], 'b': 2.0})  # {'a': ['X', 1], 'b': 2.0}",
+    .tp_traverse = (traverseproc)traverse,
+    .tp_clear = (inquiry)clear,
+    .tp_base = &Walker_Type,
+    .tp_init = (initproc)typed_init,
+    .tp_new = PyType_GenericNew,
+};
@@ -7,20 +7,12 @@ struct WhenPredicate {
     PyObject * predicate;
     PyObject * function;
     vectorcallfunc vectorcall;
+    Predicate test;
 };
 
-static int run_predicate(PyObject * pred, PyObject** args, size_t nargsf, PyObject* kwnames) {
-    PyObject * res = PyObject_Vectorcall(pred, args, nargsf, kwnames);
-
-    if (!res) return -1;
-    int status = PyObject_IsTrue(res);
-    Py_DECREF(res);
-    return status;
-}
-
 static PyObject * vectorcall(WhenPredicate * self, PyObject** args, size_t nargsf, PyObject* kwnames) {
 
-    switch (run_predicate(self->predicate, args, nargsf, kwnames)) {
+    switch (self->test(args, nargsf, kwnames)) {
         case 0:
             Py_RETURN_NONE;
         case 1:
@@ -75,6 +67,7 @@ static PyObject * create(PyTypeObject *type, PyObject *args, PyObject *kwds) {
     }
 
     self->predicate = Py_NewRef(predicate);
+    self->test = Predicate(predicate);
     self->function = Py_NewRef(function);
     self->vectorcall = (vectorcallfunc)vectorcall;
 
@@ -139,8 +139,13 @@ def cond(*args):
     return result
 
 
-def lazy(func, *args):
-    """lazy(func, *args) -> a thunk that calls func(*args) when invoked (ignores call-time args)."""
+def lazy(func, *args, once=False):
+    """lazy(func, *args, once=False) -> a thunk that calls func(*args) when invoked (ignores call-time args).
+
+    With once=True the result (or exception) of the first call is cached, see delay.
+    """
+    if once:
+        return _backend_mod.delay(func, *args)
     return _backend_mod.partial(func, *args, required=0)
 
 
@@ -7,8 +7,16 @@ public API exercised by the test suite), not performance.
 
 from __future__ import annotations
 
+import contextlib
+import copy
+import dataclasses
 import functools
+import math
 import sys
+import threading
+import time
+import weakref
+from collections import OrderedDict
 from typing import Any, Callable, Dict, Iterable, Mapping, MutableMapping, Sequence, Tuple
 
 
@@ -38,44 +46,113 @@ def first_arg(*args: Any, **kwargs: Any) -> Any:
     return args[0]
 
 
-def compose(f: Callable[[Any], Any], g: Callable[..., Any]) -> Callable[..., Any]:
-    """compose(f, g)(*args, **kwargs) == f(g(*args, **kwargs))."""
+def _compose_stages(func: Callable[..., Any]) -> Tuple[Callable[..., Any], ...]:
+    """Call-order stages of `func`, splicing in nested compositions."""
 
-    if not callable(f) or not callable(g):
-        raise TypeError("compose() expects callables")
+    return getattr(func, "__compose_stages__", (func,))
+
+
+def _fuse_stages(stages: Sequence[Callable[..., Any]]) -> Tuple[Callable[..., Any], ...]:
+    """Drop identities after the first stage and any constantly feeding another constantly."""
+
+    fused = [stages[0]]
+    for s in stages[1:]:
+        if s is identity:
+            continue
+        if getattr(s, "__constantly__", False) and getattr(fused[-1], "__constantly__", False):
+            fused.pop()
+        fused.append(s)
+    return tuple(fused)
+
+
+def _pipeline(stages: Tuple[Callable[..., Any], ...]) -> Callable[..., Any]:
+    first, rest = stages[0], stages[1:]
 
-    @functools.wraps(f)
     def _composed(*args: Any, **kwargs: Any) -> Any:
-        return f(g(*args, **kwargs))
+        v = first(*args, **kwargs)
+        for f in rest:
+            v = f(v)
+        return v
 
+    _composed.__compose_stages__ = stages
+    _composed.functions = stages
     return _composed
 
 
-def composeN(*funcs: Any) -> Callable[..., Any]:
+def compose(f: Callable[[Any], Any], g: Callable[..., Any]) -> Callable[..., Any]:
+    """compose(f, g)(*args, **kwargs) == f(g(*args, **kwargs)).
+
+    Nested compositions are flattened; the call-order stages are in `.functions`.
+    """
+
+    if not callable(f) or not callable(g):
+        raise TypeError("compose() expects callables")
+
+    composed = _pipeline(_fuse_stages(_compose_stages(g) + _compose_stages(f)))
+    functools.update_wrapper(composed, f, updated=())
+    return composed
+
+
+def composeN(*funcs: Any, live: bool = False) -> Callable[..., Any]:
     """
     composeN(f1, f2, f3)(x) == f3(f2(f1(x))).
 
     If passed a single list/tuple, it is treated as the function sequence.
+    Nested compositions are flattened; a list is snapshotted until
+    `.refresh()` is called, or read on every call with live=True.
 
     Alias: `sequence`
     """
 
+    source: Any = funcs
     if len(funcs) == 1 and isinstance(funcs[0], (list, tuple)):
-        funcs = tuple(funcs[0])
-
-    if not funcs:
-        raise TypeError("composeN() requires at least one function")
-
-    for f in funcs:
-        if not callable(f):
-            raise TypeError("composeN() expects callables")
+        source = funcs[0]
+
+    if live:
+        if not isinstance(source, list):
+            raise TypeError("composeN(live=True) takes a single list of functions")
+
+        def _live(*args: Any, **kwargs: Any) -> Any:
+            if not source:
+                raise TypeError("composeN has no functions to call")
+            v = source[0](*args, **kwargs)
+            i = 1
+            while i < len(source):
+                v = source[i](v)
+                i += 1
+            return v
+
+        _live.functions = source
+        _live.refresh = lambda: None
+        return _live
+
+    def resolve() -> Tuple[Callable[..., Any], ...]:
+        if not source:
+            raise TypeError("composeN() requires at least one function")
+        for f in source:
+            if not callable(f):
+                raise TypeError("composeN() expects callables")
+        return _fuse_stages(sum((_compose_stages(f) for f in source), ()))
+
+    stages = resolve()
 
     def _composed(*args: Any, **kwargs: Any) -> Any:
-        v = funcs[0](*args, **kwargs)
-        for f in funcs[1:]:
+        current = stages
+        v = current[0](*args, **kwargs)
+        for f in current[1:]:
             v = f(v)
         return v
 
+    def refresh() -> None:
+        nonlocal stages
+        stages = resolve()
+
+    if isinstance(source, list):
+        _composed.functions = source
+        _composed.refresh = refresh
+    else:
+        _composed.functions = _composed.__compose_stages__ = stages
+        _composed.refresh = lambda: None
     return _composed
 
 
@@ -129,12 +206,30 @@ def use_with(target: Callable[..., Any], *transforms: Callable[..., Any]) -> Cal
     return _use
 
 
-def and_predicate(*preds: Callable[..., Any]) -> Callable[..., bool]:
+_ADAPTIVE_MAX = 16
+
+
+def _check_adaptive(name: str, preds: tuple, adaptive: bool) -> None:
+    if adaptive and len(preds) > _ADAPTIVE_MAX:
+        raise ValueError(f"adaptive {name} takes at most {_ADAPTIVE_MAX} predicates")
+
+
+def _with_order(func: Callable[..., bool], preds: tuple) -> Callable[..., bool]:
+    # The fallback always evaluates in the given order; the attributes keep
+    # it interchangeable with the native adaptive predicates.
+    func.order = preds
+    func.adaptive_info = lambda: None
+    func.reorder = lambda: None
+    return func
+
+
+def and_predicate(*preds: Callable[..., Any], adaptive: bool = False) -> Callable[..., bool]:
     """and_predicate(p1, p2, ...)(x) -> True iff all predicates are truthy (short-circuits)."""
 
     for p in preds:
         if not callable(p):
             raise TypeError("and_predicate() expects callables")
+    _check_adaptive("and_predicate", preds, adaptive)
 
     def _and(*args: Any, **kwargs: Any) -> bool:
         for p in preds:
@@ -142,15 +237,16 @@ def and_predicate(*preds: Callable[..., Any]) -> Callable[..., bool]:
                 return False
         return True
 
-    return _and
+    return _with_order(_and, preds)
 
 
-def or_predicate(*preds: Callable[..., Any]) -> Callable[..., bool]:
+def or_predicate(*preds: Callable[..., Any], adaptive: bool = False) -> Callable[..., bool]:
     """or_predicate(p1, p2, ...)(x) -> True iff any predicate is truthy (short-circuits)."""
 
     for p in preds:
         if not callable(p):
             raise TypeError("or_predicate() expects callables")
+    _check_adaptive("or_predicate", preds, adaptive)
 
     def _or(*args: Any, **kwargs: Any) -> bool:
         for p in preds:
@@ -158,7 +254,7 @@ def or_predicate(*preds: Callable[..., Any]) -> Callable[..., bool]:
                 return True
         return False
 
-    return _or
+    return _with_order(_or, preds)
 
 
 def not_predicate(pred: Callable[..., Any]) -> Callable[..., bool]:
@@ -173,6 +269,43 @@ def not_predicate(pred: Callable[..., Any]) -> Callable[..., bool]:
     return _not
 
 
+def map_batch(function: Callable[[Any], Any], seq: Iterable[Any]) -> list:
+    """map_batch(function, seq) -> list(map(function, seq))."""
+
+    if not callable(function):
+        raise TypeError(f"map_batch() expects a callable, got {type(function)}")
+    return list(map(function, tuple(seq)))
+
+
+def filter_batch(pred: Callable[[Any], Any], seq: Iterable[Any]) -> list:
+    """filter_batch(pred, seq) -> [x for x in seq if pred(x)]."""
+
+    if not callable(pred):
+        raise TypeError(f"filter_batch() expects a callable, got {type(pred)}")
+    return [x for x in tuple(seq) if pred(x)]
+
+
+class _CompiledPredicate:
+    """Result of compile_predicate(); the pure version keeps the tree as one opaque call."""
+
+    def __init__(self, source: Callable[..., Any]):
+        self.source = source
+
+    def __call__(self, *args: Any, **kwargs: Any) -> bool:
+        return bool(self.source(*args, **kwargs))
+
+    def disassemble(self) -> str:
+        return f"   0 CALL       {self.source!r}  true -> True, false -> False"
+
+
+def compile_predicate(pred: Callable[..., Any]) -> Callable[..., bool]:
+    """compile_predicate(pred) -> predicate equivalent to pred, with disassemble()."""
+
+    if not callable(pred):
+        raise TypeError(f"compile_predicate expects a callable, got {pred!r}")
+    return _CompiledPredicate(pred)
+
+
 class TypePredicate:
     """TypePredicate(cls)(obj) -> True iff type(obj) is exactly cls (no subclass matching)."""
 
@@ -345,15 +478,67 @@ def firstof(*functions: Callable[..., Any]) -> Callable[..., Any]:
     return _firstof
 
 
+def _check_arity(func: Callable[..., Any], required: int | None, args: tuple[Any, ...]) -> None:
+    if required is not None and len(args) != required:
+        raise TypeError(
+            f"partial of {func!r} takes {required} positional argument{'' if required == 1 else 's'} ({len(args)} given)"
+        )
+
+
+class _PlaceholderType:
+    """Type of Placeholder, which marks a partial argument filled at call time."""
+
+    __slots__ = ()
+
+    def __repr__(self) -> str:
+        return "Placeholder"
+
+    def __reduce__(self) -> str:
+        return "Placeholder"
+
+
+Placeholder = _PlaceholderType()
+
+
 def partial(func: Callable[..., Any], *pargs: Any, required: int | None = None, **pkwargs: Any) -> Callable[..., Any]:
     """partial(func, *args, required=None, **kwargs) -> callable (pure-Python fallback)."""
 
     if not callable(func):
         raise TypeError("partial() expects a callable")
 
-    if required is not None and required != 0:
-        # The native implementation supports richer semantics; this fallback only implements what tests cover.
-        raise NotImplementedError("pure partial() only supports required=None or required=0")
+    if required is not None:
+        if not isinstance(required, int):
+            raise TypeError(f"required parameter: {required!r} wasn't int")
+        if required < 0:
+            raise TypeError(f"required parameter: {required!r} must be >= 0")
+
+    if pargs and pargs[-1] is Placeholder:
+        raise TypeError("trailing Placeholders are not allowed")
+    if any(v is Placeholder for v in pkwargs.values()):
+        raise TypeError("Placeholder cannot be passed as a keyword argument")
+
+    holes = [i for i, a in enumerate(pargs) if a is Placeholder]
+
+    if holes:
+        if required == 0:
+            raise TypeError("Placeholders are not allowed with required=0")
+        if required is not None and required < len(holes):
+            raise TypeError(f"required={required} is fewer than the {len(holes)} Placeholders")
+
+        def _holes(*args: Any, **kwargs: Any) -> Any:
+            _check_arity(func, required, args)
+            if len(args) < len(holes):
+                raise TypeError(
+                    f"missing positional arguments in 'partial' call; expected at least {len(holes)}, got {len(args)}"
+                )
+            filled = list(pargs)
+            for i, a in zip(holes, args):
+                filled[i] = a
+            merged = dict(pkwargs)
+            merged.update(kwargs)
+            return func(*filled, *args[len(holes):], **merged)
+
+        return _holes
 
     if required == 0:
         def _thunk(*args: Any, **kwargs: Any) -> Any:
@@ -362,6 +547,7 @@ def partial(func: Callable[..., Any], *pargs: Any, required: int | None = None,
         return _thunk
 
     def _p(*args: Any, **kwargs: Any) -> Any:
+        _check_arity(func, required, args)
         merged = dict(pkwargs)
         merged.update(kwargs)
         return func(*pargs, *args, **merged)
@@ -369,6 +555,50 @@ def partial(func: Callable[..., Any], *pargs: Any, required: int | None = None,
     return _p
 
 
+class _Delay:
+    """Pure-Python fallback for delay: func(*args), evaluated once under a lock."""
+
+    __slots__ = ("_func", "_args", "_lock", "_owner", "_done", "_result", "_failed", "_traceback")
+
+    def __init__(self, func: Callable[..., Any], args: Tuple[Any, ...]) -> None:
+        self._func = func
+        self._args = args
+        self._lock = threading.Lock()
+        self._owner: int | None = None
+        self._done = False
+        self._result: Any = None
+        self._failed = False
+        self._traceback: Any = None
+
+    def __call__(self, *args: Any, **kwargs: Any) -> Any:
+        if not self._done:
+            if self._owner == threading.get_ident():
+                raise RuntimeError("lazy value depends on itself")
+            with self._lock:
+                if not self._done:
+                    self._owner = threading.get_ident()
+                    try:
+                        self._result = self._func(*self._args)
+                    except BaseException as e:
+                        self._result, self._failed, self._traceback = e, True, e.__traceback__
+                    finally:
+                        self._owner = None
+                    self._args = ()
+                    self._done = True
+        if self._failed:
+            # re-raising grows the traceback, restart from the original one
+            raise self._result.with_traceback(self._traceback)
+        return self._result
+
+
+def delay(func: Callable[..., Any], *args: Any) -> Callable[..., Any]:
+    """delay(func, *args) computes func(*args) on the first call and returns the cached outcome after."""
+
+    if not callable(func):
+        raise TypeError(f"delay() expects a callable, got {func!r}")
+    return _Delay(func, args)
+
+
 def always(value: Any) -> Callable[..., Any]:
     """always(x) returns a callable that ignores its args; if x is callable it is invoked with no args."""
 
@@ -402,6 +632,7 @@ def constantly(value: Any) -> Callable[..., Any]:
     def _const(*args: Any, **kwargs: Any) -> Any:
         return value
 
+    _const.__constantly__ = True
     return _const
 
 
@@ -621,28 +852,226 @@ def method_invoker(obj: Any, method_name: str, lookup_error: BaseException | Non
     return _invoke
 
 
-def memoize_one_arg(func: Callable[[Any], Any]) -> Callable[[Any], Any]:
-    """memoize_one_arg(func)(x) caches results by object identity (id(x))."""
+def memoize_one_arg(
+    func: Callable[[Any], Any], maxsize: int | None = None, policy: str = "lru"
+) -> Callable[[Any], Any]:
+    """memoize_one_arg(func, maxsize=None, policy='lru')(x) caches results by object identity (id(x)).
+
+    When `maxsize` is set the least recently used entry is evicted; 'clock' is
+    accepted for API compatibility and behaves like 'lru' here.
+    """
 
     if not callable(func):
         raise TypeError("memoize_one_arg() expects a callable")
+    if maxsize is not None and (not isinstance(maxsize, int) or maxsize <= 0):
+        raise ValueError("maxsize must be None or a positive int")
+    if policy not in ("lru", "clock"):
+        raise ValueError("policy must be 'lru' or 'clock'")
 
-    cache: Dict[int, Any] = {}
-    keepalive: Dict[int, Any] = {}
+    cache: "OrderedDict[int, Tuple[Any, Any]]" = OrderedDict()
+    stats = {"hits": 0, "misses": 0, "evictions": 0, "weakref_evictions": 0}
+
+    def _drop(k: int) -> None:
+        if cache.pop(k, None) is not None:
+            stats["weakref_evictions"] += 1
 
     @functools.wraps(func)
     def _memo(x: Any) -> Any:
         k = id(x)
         if k in cache:
-            return cache[k]
+            stats["hits"] += 1
+            cache.move_to_end(k)
+            return cache[k][1]
+        stats["misses"] += 1
         r = func(x)
+        try:
+            # like the native cache, drop the entry when a weakly referenceable key dies
+            cache[k] = (weakref.ref(x, lambda _, k=k: _drop(k)), r)
+        except TypeError:
+            cache[k] = (x, r)
+        if maxsize is not None and len(cache) > maxsize:
+            stats["evictions"] += 1
+            cache.popitem(last=False)
+        return r
+
+    def _cache_info() -> Dict[str, int]:
+        return dict(stats, size=len(cache), maxsize=-1 if maxsize is None else maxsize, bytes=sys.getsizeof(cache))
+
+    _memo.cache_info = _cache_info  # type: ignore[attr-defined]
+    return _memo
+
+
+def memoize(func: Callable[..., Any], by_value: Any = False) -> Callable[..., Any]:
+    """memoize(func, by_value=False) caches results over all positional and keyword arguments.
+
+    Arguments are keyed by identity unless selected by `by_value`: True for all
+    arguments, or an iterable of positional indices and keyword names.
+    """
+
+    if not callable(func):
+        raise TypeError("memoize() expects a callable")
+
+    positions: frozenset = frozenset()
+    names: frozenset = frozenset()
+    all_by_value = by_value is True
+    if by_value not in (None, False, True):
+        positions = frozenset(i for i in by_value if isinstance(i, int))
+        names = frozenset(n for n in by_value if isinstance(n, str))
+
+    cache: Dict[Any, Any] = {}
+    keepalive: Dict[Any, Any] = {}
+    stats = {"hits": 0, "misses": 0}
+
+    def _key(i: Any, v: Any) -> Any:
+        if all_by_value or i in positions or i in names:
+            return (True, v)
+        return (False, id(v))
+
+    @functools.wraps(func)
+    def _memo(*args: Any, **kwargs: Any) -> Any:
+        k = (
+            tuple(_key(i, a) for i, a in enumerate(args)),
+            tuple((n, _key(n, v)) for n, v in kwargs.items()),
+        )
+        if k in cache:
+            stats["hits"] += 1
+            return cache[k]
+        stats["misses"] += 1
+        r = func(*args, **kwargs)
         cache[k] = r
-        keepalive[k] = x
+        keepalive[k] = (args, kwargs)
         return r
 
+    def _cache_info() -> Dict[str, int]:
+        return dict(stats, size=len(cache), maxsize=-1, bytes=sys.getsizeof(cache))
+
+    def _clear() -> None:
+        cache.clear()
+        keepalive.clear()
+
+    _memo.clear = _clear  # type: ignore[attr-defined]
+    _memo.cache_info = _cache_info  # type: ignore[attr-defined]
     return _memo
 
 
+class Cache:
+    """Cache(lookup, negative_ttl=None)(obj) caches lookup(obj) by identity.
+
+    None results are only cached when `negative_ttl` is given, and are looked
+    up again once it has elapsed.
+    """
+
+    def __init__(self, lookup: Callable[[Any], Any], negative_ttl: float | None = None):
+        if not callable(lookup):
+            raise TypeError(f"Cache lookup must be callable, got {lookup!r}")
+        if negative_ttl is not None and not negative_ttl > 0:
+            raise ValueError(f"negative_ttl must be None or a positive number of seconds, not {negative_ttl!r}")
+        self.lookup = lookup
+        self._ttl = negative_ttl
+        # id(key) -> (key, value, expires); expires is None for entries that never expire
+        self._cache: Dict[int, Tuple[Any, Any, float | None]] = {}
+        self._stats = {"hits": 0, "misses": 0, "evictions": 0, "weakref_evictions": 0}
+
+    def _expires(self, value: Any) -> float | None:
+        if value is not None or self._ttl is None or math.isinf(self._ttl):
+            return None
+        return time.monotonic() + self._ttl
+
+    def _live(self, entry: Tuple[Any, Any, float | None]) -> bool:
+        return entry[2] is None or time.monotonic() < entry[2]
+
+    def __call__(self, obj: Any) -> Any:
+        entry = self._cache.get(id(obj))
+        if entry is not None:
+            if self._live(entry):
+                self._stats["hits"] += 1
+                return entry[1]
+            del self._cache[id(obj)]
+            self._stats["evictions"] += 1
+        self._stats["misses"] += 1
+        value = self.lookup(obj)
+        if value is not None or self._ttl is not None:
+            self._cache[id(obj)] = (obj, value, self._expires(value))
+        return value
+
+    def prefill(self, mapping: Mapping[Any, Any]) -> None:
+        for k, v in mapping.items():
+            self._cache[id(k)] = (k, v, self._expires(v))
+
+    def invalidate(self, key: Any) -> bool:
+        return self._cache.pop(id(key), None) is not None
+
+    def clear(self) -> None:
+        self._cache.clear()
+
+    def cache_info(self) -> Dict[str, int]:
+        return dict(self._stats, size=len(self._cache), maxsize=-1, bytes=sys.getsizeof(self._cache))
+
+    def __len__(self) -> int:
+        return len(self._cache)
+
+    def __contains__(self, key: Any) -> bool:
+        entry = self._cache.get(id(key))
+        return entry is not None and self._live(entry)
+
+
+class ThreadLocalError(RuntimeError):
+    """Raised when a ThreadLocalProxy is used on a thread with no target set."""
+
+
+class ThreadLocalProxy:
+    """ThreadLocalProxy(error=None) forwards calls, attributes and iteration to a per-thread target."""
+
+    def __init__(self, error: type | None = None):
+        if error is not None and not (isinstance(error, type) and issubclass(error, BaseException)):
+            raise TypeError(f"ThreadLocalProxy error must be an exception class, got {error!r}")
+        object.__setattr__(self, "_local", threading.local())
+        object.__setattr__(self, "_error", error or ThreadLocalError)
+
+    @staticmethod
+    def _target(proxy: "ThreadLocalProxy") -> Any:
+        target = getattr(object.__getattribute__(proxy, "_local"), "target", None)
+        if target is None:
+            raise object.__getattribute__(proxy, "_error")
+        return target
+
+    @classmethod
+    def set(cls, proxy: "ThreadLocalProxy", target: Any) -> Any:
+        local = object.__getattribute__(proxy, "_local")
+        prev = getattr(local, "target", None)
+        local.target = target
+        return prev
+
+    @classmethod
+    def get(cls, proxy: "ThreadLocalProxy") -> Any:
+        return getattr(object.__getattribute__(proxy, "_local"), "target", None)
+
+    @classmethod
+    @contextlib.contextmanager
+    def swap(cls, proxy: "ThreadLocalProxy", target: Any) -> Any:
+        prev = cls.set(proxy, target)
+        try:
+            yield target
+        finally:
+            cls.set(proxy, prev)
+
+    def __call__(self, *args: Any, **kwargs: Any) -> Any:
+        return ThreadLocalProxy._target(self)(*args, **kwargs)
+
+    def __getattr__(self, name: str) -> Any:
+        return getattr(ThreadLocalProxy._target(self), name)
+
+    def __setattr__(self, name: str, value: Any) -> None:
+        setattr(ThreadLocalProxy._target(self), name, value)
+
+    def __iter__(self) -> Any:
+        return iter(ThreadLocalProxy._target(self))
+
+    def __repr__(self) -> str:
+        target = ThreadLocalProxy.get(self)
+        return "<ThreadLocalProxy: unset>" if target is None else repr(target)
+
+
 def when_not_none(func: Callable[..., Any]) -> Callable[..., Any]:
     """when_not_none(func)(*args, **kwargs) returns None without calling func if any arg/kwarg is None."""
 
@@ -677,40 +1106,225 @@ def either(first_fn: Callable[..., Any], second_fn: Callable[..., Any]) -> Calla
     return _either
 
 
-def walker(transform: Callable[[Any], Any]) -> Callable[[Any], Any]:
-    """walker(transform)(obj) recursively applies transform to leaf values of tuples/lists/dicts."""
+class _Walker:
+    """walker(transform, *, extended=False, keys=False, preserve_identity=False)(obj)
+    recursively applies transform to leaf values of tuples/lists/dicts, and with
+    extended=True of sets, namedtuples, tuple/list/dict subclasses, dataclasses
+    and __slots__ objects. register(cls, handler) adds handler(obj, walker) for
+    cls. preserve_identity walks each object once per call, keeping sharing and
+    cycles. parallel is accepted for compatibility, the walk is always
+    sequential."""
+
+    def __init__(self, transform: Callable[[Any], Any], *, extended: bool = False, keys: bool = False,
+                 preserve_identity: bool = False, parallel: int = 1):
+        if not callable(transform):
+            raise TypeError("walker() expects a callable")
+        if parallel < 1:
+            raise ValueError(f"parallel must be at least 1, not {parallel}")
+        self._transform = transform
+        self._extended = extended
+        self._keys = keys
+        self._preserve_identity = preserve_identity
+        self._local = threading.local()
+        self._handlers: Dict[type, Callable[[Any, Any], Any]] = {}
+
+    def register(self, cls: type, handler: Callable[[Any, Any], Any]) -> None:
+        if not isinstance(cls, type):
+            raise TypeError(f"register() expects a type, got {type(cls)}")
+        if not callable(handler):
+            raise TypeError(f"register() expects a callable handler, got {type(handler)}")
+        self._handlers[cls] = handler
+
+    def _items(self, items: Any) -> Tuple[list, bool]:
+        out = [self(x) for x in items]
+        return out, any(y is not x for x, y in zip(items, out))
+
+    def _dict(self, obj: Mapping[Any, Any]) -> Any:
+        items = [(self(k) if self._keys else k, self(v)) for k, v in obj.items()]
+        if all(k2 is k and v2 is v for (k, v), (k2, v2) in zip(obj.items(), items)):
+            return obj
+        if type(obj) is dict:
+            return dict(items)
+        out = obj.copy()
+        out.clear()
+        for k, v in items:
+            out[k] = v
+        return out
+
+    def _attributes(self, obj: Any, names: Sequence[str]) -> Any:
+        out = None
+        for name in names:
+            try:
+                value = getattr(obj, name)
+            except AttributeError:
+                continue
+            new = self(value)
+            if new is not value:
+                if out is None:
+                    out = copy.copy(obj)
+                object.__setattr__(out, name, new)
+        return obj if out is None else out
+
+    def __call__(self, obj: Any) -> Any:
+        if not self._preserve_identity:
+            return self._walk(obj)
+        memo = getattr(self._local, "memo", None)
+        if memo is not None:
+            return self._walk_memoized(obj, memo)
+        self._local.memo = memo = {}
+        try:
+            return self._walk_memoized(obj, memo)
+        finally:
+            self._local.memo = None
+
+    def _walk_memoized(self, obj: Any, memo: Dict[int, list]) -> Any:
+        if obj is None:
+            return None
+        # [obj (kept alive for its id), result, pending stand-in for cycles]
+        entry = memo.get(id(obj))
+        if entry is None:
+            memo[id(obj)] = entry = [obj, _WALK_MISSING, None]
+        elif entry[1] is not _WALK_MISSING:
+            return entry[1]
+        elif entry[2] is not None:
+            return entry[2]
+        else:
+            pending = self._pending(obj)
+            if pending is _WALK_MISSING:
+                return obj
+            if pending is not None:
+                entry[2] = pending
+                return pending
+        result = self._walk(obj)
+        if entry[1] is not _WALK_MISSING:
+            return entry[1]
+        if entry[2] is not None:
+            self._fill(entry[2], result)
+            result = entry[2]
+        entry[1] = result
+        return result
 
-    if not callable(transform):
-        raise TypeError("walker() expects a callable")
-
-    def _walk(obj: Any) -> Any:
-        if isinstance(obj, tuple):
-            changed = False
-            out = []
-            for x in obj:
-                y = _walk(x)
-                changed = changed or (y is not x)
-                out.append(y)
-            return tuple(out) if changed else obj
-        if isinstance(obj, list):
-            changed = False
-            out = []
-            for x in obj:
-                y = _walk(x)
-                changed = changed or (y is not x)
-                out.append(y)
-            return out if changed else obj
+    def _handler(self, cls: type) -> Any:
+        return next((self._handlers[b] for b in cls.__mro__ if b in self._handlers), None)
+
+    def _attribute_names(self, obj: Any) -> Sequence[str]:
+        cls = type(obj)
+        if dataclasses.is_dataclass(cls):
+            return [f.name for f in dataclasses.fields(cls)]
+        slots = [name for base in cls.__mro__ for name, d in vars(base).items()
+                 if type(d).__name__ == "member_descriptor" and base.__module__ != "builtins"]
+        return [] if hasattr(obj, "__dict__") else slots
+
+    def _pending(self, obj: Any) -> Any:
+        # an empty stand-in for a mutable container, None to walk an
+        # immutable one again, _WALK_MISSING to leave obj as it is
+        cls = type(obj)
+        if cls in (list, dict, set):
+            return cls()
+        if cls is tuple:
+            return None
+        if not self._extended or self._handler(cls):
+            return _WALK_MISSING
+        if isinstance(obj, (tuple, frozenset)):
+            return None
+        if isinstance(obj, (list, dict, set)):
+            out = copy.copy(obj)
+            out.clear()
+            return out
+        return copy.copy(obj) if self._attribute_names(obj) else _WALK_MISSING
+
+    def _fill(self, pending: Any, walked: Any) -> None:
+        if isinstance(pending, list):
+            pending.extend(walked)
+        elif isinstance(pending, (dict, set)):
+            pending.update(walked)
+        else:
+            for name in self._attribute_names(pending):
+                try:
+                    object.__setattr__(pending, name, getattr(walked, name))
+                except AttributeError:
+                    pass
+
+    def _walk(self, obj: Any) -> Any:
+        cls = type(obj)
+        if obj is None:
+            return None
+        if cls not in (tuple, list, dict):
+            handler = self._handler(cls)
+            if handler is not None:
+                return handler(obj, self)
+        if cls is tuple or cls is list:
+            out, changed = self._items(obj)
+            return (out if cls is list else tuple(out)) if changed else obj
+        if cls is dict:
+            return self._dict(obj)
+        if not self._extended:
+            return self._leaf(obj)
+        if isinstance(obj, (tuple, list, set, frozenset)):
+            out, changed = self._items(tuple(obj))
+            if not changed:
+                return obj
+            if isinstance(obj, tuple) and hasattr(cls, "_fields") and hasattr(cls, "_make"):
+                return cls._make(out)
+            return cls(out)
         if isinstance(obj, dict):
-            changed = False
-            out: Dict[Any, Any] = {}
-            for k, v in obj.items():
-                v2 = _walk(v)
-                changed = changed or (v2 is not v)
-                out[k] = v2
-            return out if changed else obj
-        return transform(obj)
+            return self._dict(obj)
+        names = self._attribute_names(obj)
+        if names:
+            return self._attributes(obj, names)
+        return self._leaf(obj)
+
+    def _leaf(self, obj: Any) -> Any:
+        return self._transform(obj)
+
+
+class _TypedWalker(_Walker):
+    """typed_walker(types, transform, *, extended=False, keys=False, preserve_identity=False)(obj)
+    walks like walker but applies transform only to objects of the given types
+    (or matching an isinstanceof predicate); anything else it doesn't walk is
+    returned as it is."""
+
+    def __init__(self, types: Any, transform: Callable[[Any], Any], **kwargs: Any):
+        if isinstance(types, type):
+            types = (types,)
+        if isinstance(types, (tuple, list, set, frozenset)):
+            types = tuple(types)
+            for t in types:
+                if not isinstance(t, type):
+                    raise TypeError(f"typed_walker() expects types, got {type(t)}")
+            self._matches = lambda obj: issubclass(type(obj), types)
+        elif callable(types):
+            self._matches = types
+        else:
+            raise TypeError(f"typed_walker() expects a type, a collection of types or an isinstanceof predicate, got {type(types)}")
+        super().__init__(transform, **kwargs)
+
+    def _walk(self, obj: Any) -> Any:
+        cls = type(obj)
+        if obj is not None and self._matches(obj) and (cls in (tuple, list, dict) or self._handler(cls) is None):
+            return self._transform(obj)
+        return super()._walk(obj)
+
+    def _leaf(self, obj: Any) -> Any:
+        return obj
+
+
+_WALK_MISSING = object()
+
+
+def walker(transform: Callable[[Any], Any], *, extended: bool = False, keys: bool = False,
+           preserve_identity: bool = False, parallel: int = 1) -> _Walker:
+    """walker(transform)(obj) recursively applies transform to leaf values of tuples/lists/dicts."""
+
+    return _Walker(transform, extended=extended, keys=keys, preserve_identity=preserve_identity, parallel=parallel)
+
+
+def typed_walker(types: Any, transform: Callable[[Any], Any], *, extended: bool = False, keys: bool = False,
+                 preserve_identity: bool = False, parallel: int = 1) -> _TypedWalker:
+    """typed_walker(types, transform)(obj) walks obj, applying transform only to objects of the given types."""
 
-    return _walk
+    return _TypedWalker(types, transform, extended=extended, keys=keys, preserve_identity=preserve_identity,
+                        parallel=parallel)
 
 
 def deepwrap(wrapper: Callable[[Any], Any], func: Callable[..., Any]) -> Callable[..., Any]:
@@ -730,7 +1344,20 @@ def deepwrap(wrapper: Callable[[Any], Any], func: Callable[..., Any]) -> Callabl
     return _deep
 
 
+def pool_info() -> Dict[str, Dict[str, int]]:
+    """pool_info() reports the native freelists; the pure backend has none."""
+
+    def _empty() -> Dict[str, int]:
+        return {"hits": 0, "misses": 0, "evictions": 0, "weakref_evictions": 0, "size": 0, "maxsize": 0, "bytes": 0}
+
+    return {"deepwrap": _empty(), "shared": _empty()}
+
+
 __all__ = [
+    "Cache",
+    "Placeholder",
+    "ThreadLocalError",
+    "ThreadLocalProxy",
     "TypePredicate",
     "advice",
     "always",
@@ -738,14 +1365,17 @@ __all__ = [
     "anyargs",
     "apply",
     "callall",
+    "compile_predicate",
     "compose",
     "composeN",
     "constantly",
     "deepwrap",
+    "delay",
     "dispatch",
     "dropargs",
     "either",
     "first",
+    "filter_batch",
     "first_arg",
     "firstof",
     "identity",
@@ -755,7 +1385,9 @@ __all__ = [
     "intercept",
     "isinstanceof",
     "mapargs",
+    "memoize",
     "memoize_one_arg",
+    "map_batch",
     "method_invoker",
     "not_predicate",
     "notinstance_test",
@@ -763,12 +1395,14 @@ __all__ = [
     "param",
     "positional_param",
     "partial",
+    "pool_info",
     "repeatedly",
     "selfapply",
     "sequence",
     "side_effect",
     "spread",
     "ternary_predicate",
+    "typed_walker",
     "typeof",
     "use_with",
     "walker",
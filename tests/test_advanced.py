@@ -1,4 +1,8 @@
 """Tests for advanced utilities: walker, deepwrap, dispatch."""
+import collections
+import dataclasses
+import functools
+
 import pytest
 import retracesoftware.functional as fn
 
@@ -75,6 +79,368 @@ class TestWalker:
         }
 
 
+Point = collections.namedtuple("Point", "x y")
+
+
+@dataclasses.dataclass(frozen=True)
+class Record:
+    id: int
+    tags: list
+
+
+class Slotted:
+    __slots__ = ("a", "__b", "unset")
+
+    def __init__(self, a, b):
+        self.a = a
+        self.__b = b
+
+
+def _inc(x):
+    return x + 1 if type(x) is int else x
+
+
+class TestWalkerContainers:
+    def test_plain_walker_keeps_other_types_as_leaves(self):
+        seen = []
+        walker = fn.walker(lambda x: seen.append(x) or x)
+        point = Point(1, 2)
+
+        assert walker([point, {1}]) == [point, {1}]
+        assert seen == [point, {1}]
+
+    def test_sets_and_frozensets(self):
+        walker = fn.walker(_inc, extended=True)
+
+        assert walker({1, 2}) == {2, 3}
+        result = walker(frozenset([1]))
+        assert type(result) is frozenset and result == frozenset([2])
+
+    def test_namedtuples_and_subclasses(self):
+        class Pair(tuple):
+            pass
+
+        walker = fn.walker(_inc, extended=True)
+
+        assert walker(Point(1, (2,))) == Point(2, (3,))
+        assert type(walker(Point(1, 2))) is Point
+        assert type(walker(Pair((1, 2)))) is Pair
+
+    def test_dict_subclasses(self):
+        walker = fn.walker(_inc, extended=True)
+
+        ordered = walker(collections.OrderedDict(a=1, b=2))
+        assert type(ordered) is collections.OrderedDict and list(ordered.items()) == [("a", 2), ("b", 3)]
+
+        default = walker(collections.defaultdict(list, a=1))
+        assert default.default_factory is list and default["a"] == 2
+
+    def test_dataclasses_and_slots(self):
+        walker = fn.walker(_inc, extended=True)
+
+        record = Record(1, [2])
+        assert walker(record) == Record(2, [3])
+        assert record == Record(1, [2])
+
+        result = walker(Slotted(1, 2))
+        assert (result.a, result._Slotted__b) == (2, 3)
+        assert not hasattr(result, "unset")
+
+    def test_copy_on_write(self):
+        walker = fn.walker(lambda x: x, extended=True, keys=True)
+
+        for value in (Point(1, 2), {1, 2}, Record(1, [2]), collections.OrderedDict(a=1), {"a": [1]}):
+            assert walker(value) is value
+
+    def test_dict_keys(self):
+        data = {1: "a", (2,): "b", 3: 4}
+
+        assert fn.walker(_inc)(data) == {1: "a", (2,): "b", 3: 5}
+        assert fn.walker(_inc, keys=True)(data) == {2: "a", (3,): "b", 4: 5}
+        assert list(fn.walker(_inc, keys=True)({"x": 1, 5: 2, "y": 3})) == ["x", 6, "y"]
+
+    def test_registered_handler(self):
+        class Box:
+            def __init__(self, value):
+                self.value = value
+
+        class SubBox(Box):
+            pass
+
+        walker = fn.walker(_inc)
+        walker.register(Box, lambda box, walk: Box(walk(box.value)))
+
+        assert walker([Box(1)])[0].value == 2
+        assert walker(SubBox([1])).value == [2]
+
+    def test_handler_overrides_builtin(self):
+        walker = fn.walker(_inc, extended=True)
+        assert walker(Point(1, 2)) == Point(2, 3)
+
+        walker.register(Point, lambda point, walk: point)
+        assert walker(Point(1, 2)) == Point(1, 2)
+
+    def test_class_changes_are_seen(self):
+        class Thing:
+            value: int
+
+        walker = fn.walker(_inc, extended=True)
+        thing = Thing()
+        thing.value = 1
+        assert walker(thing) is thing
+
+        dataclasses.dataclass(Thing)
+        assert walker(thing).value == 2
+
+    def test_register_rejects_non_types(self):
+        walker = fn.walker(_inc)
+
+        with pytest.raises(TypeError):
+            walker.register("int", _inc)
+        with pytest.raises(TypeError):
+            walker.register(int, 1)
+
+    def test_deep_nesting(self):
+        if fn.__backend__ == "pure":
+            pytest.skip("the pure walker recurses")
+
+        data = [1]
+        for i in range(100000):
+            data = [data, ({"k": i},)]
+
+        result = fn.walker(_inc)(data)
+        for i in reversed(range(100000)):
+            assert result[1] == ({"k": i + 1},)
+            result = result[0]
+        assert result == [2]
+
+    def test_copy_on_write_across_depths(self):
+        # deep enough to leave the recursive fast path for the frame stack
+        data = ["old"]
+        siblings = []
+        for i in range(40):
+            sibling = ("s", i)
+            siblings.append(sibling)
+            data = {"next": [data, sibling]}
+
+        renew = fn.walker(lambda x: "new" if x == "old" else x)
+        result = renew(data)
+
+        for sibling in reversed(siblings):
+            assert result["next"][1] is sibling
+            result = result["next"][0]
+        assert result == ["new"]
+
+        assert fn.walker(lambda x: x)(data) is data
+
+    @pytest.mark.parametrize("extended", [False, True])
+    def test_list_cleared_by_fn(self, extended):
+        if fn.__backend__ == "pure":
+            pytest.skip("only the native walker checks the list size")
+
+        data = [1, 2, 3, "x"]
+
+        def clear(x):
+            if x == "x":
+                data.clear()
+            return x + 1 if isinstance(x, int) else x.upper()
+
+        with pytest.raises(RuntimeError, match="changed size"):
+            fn.walker(clear, extended=extended)(data)
+
+    def test_list_shrinking_during_walk(self):
+        if fn.__backend__ == "pure":
+            pytest.skip("the pure walker stops early")
+
+        data = [1, 2, 3]
+
+        def shrink(x):
+            data.clear()
+            return x
+
+        with pytest.raises(RuntimeError):
+            fn.walker(shrink)(data)
+
+
+class TestTypedWalker:
+    def test_applies_function_to_matching_types_only(self):
+        seen = []
+        upper = fn.typed_walker(str, lambda s: seen.append(s) or s.upper())
+
+        assert upper({"a": ["x", 1], "b": 2.0, "c": ("y", b"z", None)}) == {"a": ["X", 1], "b": 2.0, "c": ("Y", b"z", None)}
+        assert seen == ["x", "y"]
+
+    def test_unmatched_payload_comes_back_by_reference(self):
+        walker = fn.typed_walker(bytes, bytes.upper)
+        data = {"rows": [[i, float(i), str(i)] for i in range(100)], "meta": (True, None)}
+
+        assert walker(data) is data
+
+    def test_subclasses_and_collections_of_types(self):
+        negate = fn.typed_walker((int, float), lambda x: -x)
+
+        assert negate([1, True, 2.5, "a"]) == [-1, -1, -2.5, "a"]
+        assert fn.typed_walker({bool}, lambda x: not x)([True, 1]) == [False, 1]
+
+    def test_isinstanceof_predicate(self):
+        walker = fn.typed_walker(fn.isinstanceof(float), lambda x: x * 2)
+        assert walker([1, "a", (1.5,)]) == [1, "a", (3.0,)]
+
+    def test_matching_containers_are_not_walked(self):
+        assert fn.typed_walker(list, len)([1, [1, 2], ([3],)]) == 3
+        assert fn.typed_walker(list, len)(([1, 2], {"a": [3]})) == (2, {"a": 1})
+        assert fn.typed_walker(Point, lambda p: p.x, extended=True)([Point(1, 2), {Point(3, 4)}]) == [1, {3}]
+
+    def test_unmatched_objects_are_left_alone(self):
+        record = Record(1, ["a"])
+        walker = fn.typed_walker(str, str.upper)
+
+        assert walker(record) is record
+        assert fn.typed_walker(str, str.upper, extended=True)(record) == Record(1, ["A"])
+
+    def test_handlers(self):
+        walker = fn.typed_walker(int, _inc)
+        walker.register(Point, lambda point, walk: Point(*walk(tuple(point))))
+
+        assert walker([Point(1, "a"), 1.5]) == [Point(2, "a"), 1.5]
+
+    def test_rejects_other_gates(self):
+        with pytest.raises(TypeError):
+            fn.typed_walker([int, 1], _inc)
+        with pytest.raises(TypeError):
+            fn.typed_walker(1, _inc)
+
+
+class TestWalkerParallel:
+    # large enough to be split on free-threaded builds, walked sequentially otherwise
+    ROWS = [[i, str(i), {"k": (i,)}] for i in range(20000)]
+
+    def test_same_result_as_sequential(self):
+        for walker in (fn.walker, functools.partial(fn.typed_walker, int)):
+            assert walker(_inc, parallel=4)(self.ROWS) == walker(_inc)(self.ROWS)
+
+        data = {i: [i] for i in range(10000)}
+        assert fn.walker(_inc, parallel=4)(data) == {i: [i + 1] for i in range(10000)}
+        assert fn.walker(_inc, parallel=4, keys=True)(data) == {i + 1: [i + 1] for i in range(10000)}
+        assert fn.walker(_inc, parallel=3)(tuple(range(10000))) == tuple(range(1, 10001))
+
+    def test_copy_on_write(self):
+        data = {i: [i] for i in range(10000)}
+
+        assert fn.walker(lambda x: x, parallel=4)(self.ROWS) is self.ROWS
+        assert fn.walker(lambda x: x, parallel=4, keys=True)(data) is data
+
+    def test_errors_propagate(self):
+        def fail_on(x):
+            if x == 7777:
+                raise KeyError(x)
+            return x
+
+        with pytest.raises(KeyError):
+            fn.walker(fail_on, parallel=4)(list(range(10000)))
+
+    def test_rejects_fewer_than_one_thread(self):
+        with pytest.raises(ValueError):
+            fn.walker(_inc, parallel=0)
+
+
+class TestWalkerPreserveIdentity:
+    def test_shared_objects_stay_shared(self):
+        shared = [1, 2]
+        walker = fn.walker(_inc, preserve_identity=True)
+
+        result = walker([shared, shared, (shared,)])
+
+        assert result == [[2, 3], [2, 3], ([2, 3],)]
+        assert result[0] is result[1] is result[2][0]
+
+    def test_shared_objects_walked_once(self):
+        calls = []
+        leaf = object()
+        walker = fn.walker(lambda x: calls.append(x) or x, preserve_identity=True)
+
+        walker([leaf, [leaf], {"k": leaf}])
+        assert calls == [leaf]
+
+        walker([leaf])
+        assert calls == [leaf, leaf]
+
+    def test_self_referencing_list(self):
+        data = [1]
+        data.append(data)
+
+        result = fn.walker(_inc, preserve_identity=True)(data)
+
+        assert result is not data
+        assert result[0] == 2 and result[1] is result
+
+    def test_self_referencing_dict(self):
+        data = {"x": 1}
+        data["self"] = data
+
+        result = fn.walker(_inc, preserve_identity=True)(data)
+
+        assert result["x"] == 2 and result["self"] is result
+
+    def test_cycle_through_tuple(self):
+        inner = [1]
+        data = (inner, 5)
+        inner.append(data)
+
+        result = fn.walker(_inc, preserve_identity=True)(data)
+
+        assert result[1] == 6
+        assert result[0][0] == 2 and result[0][1] is result
+
+    def test_cycle_through_dataclass(self):
+        @dataclasses.dataclass
+        class Node:
+            value: int
+            next: object = None
+
+        node = Node(1)
+        node.next = node
+
+        result = fn.walker(_inc, extended=True, preserve_identity=True)(node)
+
+        assert result.value == 2 and result.next is result
+        assert node.value == 1
+
+    def test_filling_a_cycle_may_walk_again(self):
+        class L(list):
+            def extend(self, items):
+                # grows the shared memo while the cycle's entry is in use
+                walker([[i] for i in range(5000)])
+                super().extend(items)
+
+        walker = fn.walker(_inc, preserve_identity=True, extended=True)
+        obj = L([1])
+        obj.append(obj)
+
+        result = walker(obj)
+
+        assert type(result) is L
+        assert result[0] == 2 and result[1] is result
+
+    def test_acyclic_input_is_copy_on_write(self):
+        data = {"a": [1, (2, 3)], "b": "x"}
+
+        assert fn.walker(lambda x: x, preserve_identity=True)(data) is data
+
+    def test_handlers_share_the_memo(self):
+        class Box:
+            def __init__(self, value):
+                self.value = value
+
+        walker = fn.walker(_inc, preserve_identity=True)
+        walker.register(Box, lambda box, walk: Box(walk(box.value)))
+        shared = [1]
+
+        result = walker([Box(shared), shared])
+
+        assert result[0].value is result[1]
+
+
 class TestDeepWrap:
     def test_wraps_result_of_function(self):
         def target(x):
@@ -124,7 +490,6 @@ class TestDeepWrap:
         assert seen_results == [10]
 
 
-@pytest.mark.skip(reason="dispatch type cannot be instantiated - not implemented")
 class TestDispatch:
     def test_matches_first_true_predicate(self):
         is_zero = lambda x: x == 0
@@ -187,6 +552,73 @@ class TestDispatch:
         assert calls == [('pred', 5, 3), ('handler', 5, 3)]
 
 
+class TestTypeDispatch:
+    def test_routes_on_isinstanceof_tests(self):
+        dispatch = fn.dispatch(
+            fn.isinstanceof(bool), lambda x: "bool",
+            fn.isinstanceof(int), lambda x: "int",
+            fn.TypePredicate(str), lambda x: "str",
+            lambda x: "other",
+        )
+
+        for _ in range(3):
+            assert dispatch(True) == "bool"
+            assert dispatch(0) == "int"
+            assert dispatch("") == "str"
+            assert dispatch(1.5) == "other"
+
+    def test_type_predicate_is_exact(self):
+        class Text(str):
+            pass
+
+        dispatch = fn.dispatch(fn.TypePredicate(str), lambda x: "str", lambda x: "other")
+
+        assert dispatch("a") == "str"
+        assert dispatch(Text("a")) == "other"
+
+    def test_falls_back_to_opaque_tests_in_order(self):
+        calls = []
+
+        def positive(x):
+            calls.append(x)
+            return x > 0
+
+        dispatch = fn.dispatch(
+            fn.isinstanceof(str), lambda x: "str",
+            positive, lambda x: "positive",
+            fn.isinstanceof(int), lambda x: "int",
+        )
+
+        assert dispatch("a") == "str"
+        assert calls == []
+        assert dispatch(5) == "positive"
+        assert dispatch(-5) == "int"
+        assert calls == [5, -5]
+
+    def test_reassigned_bases_reroute(self):
+        class A:
+            pass
+
+        class B:
+            pass
+
+        class C(A):
+            pass
+
+        dispatch = fn.dispatch(
+            fn.isinstanceof(A), lambda x: "A",
+            fn.isinstanceof(B), lambda x: "B",
+        )
+
+        assert dispatch(C()) == "A"
+        C.__bases__ = (B,)
+        assert dispatch(C()) == "B"
+
+    def test_requires_a_pair(self):
+        with pytest.raises(TypeError):
+            fn.dispatch(lambda x: True)
+
+
 class TestWhenNotNone:
     def test_calls_function_when_no_none_args(self):
         add = lambda a, b: a + b
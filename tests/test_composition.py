@@ -42,6 +42,62 @@ class TestCompose:
         assert composed.value == "TEST"
 
 
+    def test_nested_compositions_are_flattened(self):
+        inc = lambda x: x + 1
+        double = lambda x: x * 2
+
+        composed = fn.compose(inc, fn.compose(double, fn.composeN(inc, double)))
+
+        assert composed.functions == (inc, double, double, inc)
+        assert composed(3) == 17
+
+    def test_identity_stages_are_dropped(self):
+        inc = lambda x: x + 1
+
+        composed = fn.compose(fn.identity, fn.compose(inc, fn.identity))
+
+        assert composed.functions == (fn.identity, inc)
+        assert composed(1) == 2
+
+    def test_constantly_still_runs_earlier_stages(self):
+        calls = []
+        record = lambda *args: calls.append(args)
+        const = fn.constantly(42)
+
+        composed = fn.compose(str, fn.compose(const, record))
+
+        assert composed.functions == (record, const, str)
+        assert composed(1, 2) == "42"
+        assert calls == [(1, 2)]
+
+    def test_constantly_propagates_earlier_errors(self):
+        def fail(*args):
+            raise ValueError("boom")
+
+        composed = fn.sequence(fail, fn.constantly(None))
+
+        with pytest.raises(ValueError):
+            composed(1)
+
+    def test_constantly_feeding_constantly_is_dropped(self):
+        first, second = fn.constantly(1), fn.constantly(2)
+
+        composed = fn.sequence(first, second, str)
+
+        assert composed.functions == (second, str)
+        assert composed("ignored") == "2"
+
+    def test_sequence_matches_nested_calls(self):
+        steps = [lambda x, i=i: x * 3 + i for i in range(6)]
+
+        expected = 5
+        for step in steps:
+            expected = step(expected)
+
+        assert fn.sequence(*steps)(5) == expected
+        assert fn.sequence(*steps).functions == tuple(steps)
+
+
 class TestComposeN:
     def test_composes_multiple_functions_in_order(self):
         # composeN(f1, f2, f3)(x) = f3(f2(f1(x)))
@@ -53,7 +109,6 @@ class TestComposeN:
         
         assert composed("  HeLLo  ") == "[hello]"
 
-    @pytest.mark.skip(reason="composeN with single method_descriptor not iterable")
     def test_single_function_is_identity(self):
         composed = fn.composeN(str.upper)
         
@@ -66,6 +121,55 @@ class TestComposeN:
         assert composed("  hello  ") == "HELLO"
 
 
+    def test_list_is_snapshotted_until_refresh(self):
+        funcs = [str.strip, str.upper]
+        composed = fn.composeN(funcs)
+
+        funcs.append(lambda s: s + "!")
+        assert composed("  hi  ") == "HI"
+
+        composed.refresh()
+        assert composed("  hi  ") == "HI!"
+        assert composed.functions is funcs
+
+    def test_refresh_is_a_noop_without_a_list(self):
+        composed = fn.composeN((str.strip, str.upper))
+
+        composed.refresh()
+        assert composed("  hi  ") == "HI"
+        assert composed.functions == (str.strip, str.upper)
+
+    def test_refresh_during_call_finishes_old_pipeline(self):
+        funcs = []
+
+        def swap(x):
+            funcs[:] = [lambda y: y * 100]
+            composed.refresh()
+            return x + 1
+
+        funcs.extend([swap, lambda x: x * 2])
+        composed = fn.composeN(funcs)
+
+        assert composed(1) == 4
+        assert composed(1) == 100
+
+    def test_live_list_sees_mutations(self):
+        funcs = [str.strip]
+        composed = fn.composeN(funcs, live=True)
+
+        assert composed("  hi  ") == "hi"
+        funcs.append(str.upper)
+        assert composed("  hi  ") == "HI"
+
+        funcs.clear()
+        with pytest.raises(TypeError):
+            composed("hi")
+
+    def test_live_requires_list(self):
+        with pytest.raises(TypeError):
+            fn.composeN(str.strip, str.upper, live=True)
+
+
 class TestCallAll:
     def test_calls_all_functions_returns_last_result(self):
         results = []
@@ -96,6 +200,14 @@ class TestCallAll:
         call_all(None)
         assert calls == [1, 2]
 
+    def test_list_mutated_during_call(self):
+        functions = []
+        functions.extend([lambda x: functions.clear(), lambda x: x])
+
+        fn.callall(functions)(1)
+        assert functions == []
+        assert fn.callall([])(1) is None
+
 
 class TestJuxt:
     def test_returns_tuple_of_results(self):
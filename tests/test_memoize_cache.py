@@ -1,3 +1,4 @@
+import pytest
 import retracesoftware.functional as fn
 
 
@@ -16,3 +17,274 @@ def test_memoize_one_arg_caches_by_identity():
     assert calls == [id(obj)]
 
 
+
+
+def test_memoize_caches_over_positional_and_keyword_arguments():
+    calls = []
+
+    def target(a, b, c=None):
+        calls.append((a, b, c))
+        return (a, b, c)
+
+    memo = fn.memoize(target)
+    x, y = object(), object()
+
+    assert memo(x, y) == (x, y, None)
+    assert memo(x, y) == (x, y, None)
+    assert memo(x, y, c=x) == (x, y, x)
+    assert memo(x, y, c=x) == (x, y, x)
+    assert memo(y, x) == (y, x, None)
+    assert calls == [(x, y, None), (x, y, x), (y, x, None)]
+
+
+def test_memoize_keys_by_identity_unless_by_value():
+    calls = []
+
+    def target(a, b):
+        calls.append((a, b))
+        return len(calls)
+
+    memo = fn.memoize(target, by_value=[1])
+    key = object()
+
+    assert memo(key, "na" + "me".lower()) == 1
+    assert memo(key, "name") == 1
+    assert memo(object(), "name") == 2
+
+    by_value = fn.memoize(target, by_value=True)
+    assert by_value(1, (2, 3)) == 3
+    assert by_value(1, (2, 3)) == 3
+
+
+def test_memoize_by_value_unhashable_raises():
+    memo = fn.memoize(lambda a: a, by_value=True)
+    with pytest.raises(TypeError):
+        memo([1, 2])
+
+
+def test_memoize_one_arg_rejects_multiple_arguments():
+    memo = fn.memoize_one_arg(lambda x: x)
+    with pytest.raises(TypeError):
+        memo(1, 2)
+
+
+@pytest.mark.parametrize("policy", ["lru", "clock"])
+def test_memoize_one_arg_maxsize_bounds_strongly_held_keys(policy):
+    calls = []
+
+    def target(x):
+        calls.append(x)
+        return x * 2
+
+    memo = fn.memoize_one_arg(target, maxsize=2, policy=policy)
+    keys = [1000 + i for i in range(10)]
+
+    for k in keys:
+        assert memo(k) == k * 2
+    assert calls == keys
+
+    # the most recent key is still cached
+    assert memo(keys[-1]) == keys[-1] * 2
+    assert len(calls) == len(keys)
+
+
+def test_memoize_one_arg_lru_evicts_least_recently_used():
+    calls = []
+
+    def target(x):
+        calls.append(x)
+        return x
+
+    memo = fn.memoize_one_arg(target, maxsize=2)
+    a, b, c = object(), object(), object()
+
+    memo(a)
+    memo(b)
+    memo(a)      # a becomes most recently used
+    memo(c)      # evicts b
+    memo(a)
+    assert calls == [a, b, c]
+    memo(b)
+    assert calls == [a, b, c, b]
+
+
+def test_memoize_one_arg_rejects_bad_maxsize_and_policy():
+    with pytest.raises(ValueError):
+        fn.memoize_one_arg(lambda x: x, maxsize=0)
+    with pytest.raises(ValueError):
+        fn.memoize_one_arg(lambda x: x, maxsize=4, policy="fifo")
+
+
+def test_memoize_one_arg_cache_info_counts_hits_misses_and_evictions():
+    memo = fn.memoize_one_arg(lambda x: x, maxsize=2)
+
+    for k in (1001, 1002, 1001, 1003):
+        memo(k)
+
+    info = memo.cache_info()
+    assert info["size"] == 2
+    assert info["maxsize"] == 2
+    assert info["bytes"] >= 0
+    if "hits" in info:
+        assert (info["hits"], info["misses"], info["evictions"]) == (1, 3, 1)
+
+
+def test_memoize_one_arg_cache_info_counts_weakref_evictions():
+    import gc
+
+    class Key:
+        pass
+
+    memo = fn.memoize_one_arg(lambda x: 1)
+    key = Key()
+    memo(key)
+    assert memo.cache_info()["size"] == 1
+
+    del key
+    gc.collect()
+    info = memo.cache_info()
+    assert info["size"] == 0
+    if "weakref_evictions" in info:
+        assert info["weakref_evictions"] == 1
+
+
+def test_memoize_cache_info():
+    memo = fn.memoize(lambda a, b: a)
+    x = object()
+    memo(x, 1)
+    memo(x, 1)
+
+    info = memo.cache_info()
+    assert info["size"] == 1
+    if "hits" in info:
+        assert (info["hits"], info["misses"]) == (1, 1)
+
+
+def test_cache_skips_none_by_default():
+    calls = []
+
+    def lookup(x):
+        calls.append(x)
+        return None if x is int else x.__name__
+
+    cache = fn.Cache(lookup)
+    assert cache(int) is None
+    assert cache(int) is None
+    assert cache(str) == "str"
+    assert cache(str) == "str"
+    assert calls == [int, int, str]
+    assert int not in cache and str in cache
+
+
+def test_cache_negative_ttl_expires():
+    import time
+
+    calls = []
+
+    def lookup(x):
+        calls.append(x)
+        return None
+
+    cache = fn.Cache(lookup, negative_ttl=0.05)
+    assert cache(int) is None
+    assert cache(int) is None
+    assert calls == [int]
+
+    time.sleep(0.1)
+    assert int not in cache
+    assert cache(int) is None
+    assert calls == [int, int]
+
+    with pytest.raises(ValueError):
+        fn.Cache(lookup, negative_ttl=0)
+
+
+def test_cache_negative_ttl_extremes():
+    import time
+
+    calls = []
+
+    def lookup(x):
+        calls.append(x)
+        return None
+
+    tiny = fn.Cache(lookup, negative_ttl=1e-10)
+    assert tiny(int) is None
+    time.sleep(0.001)
+    assert tiny(int) is None
+    assert calls == [int, int]
+
+    for ttl in (1e12, 1e300):
+        calls.clear()
+        huge = fn.Cache(lookup, negative_ttl=ttl)
+        assert huge(int) is None
+        assert huge(int) is None
+        assert calls == [int]
+
+
+def test_cache_prefill_invalidate_clear():
+    calls = []
+
+    def lookup(x):
+        calls.append(x)
+        return "looked-up"
+
+    cache = fn.Cache(lookup, negative_ttl=float("inf"))
+    cache.prefill({int: "int", str: None})
+    assert len(cache) == 2
+    assert cache(int) == "int"
+    assert cache(str) is None
+    assert calls == []
+
+    assert cache.invalidate(int) is True
+    assert cache.invalidate(int) is False
+    assert cache(int) == "looked-up"
+    assert calls == [int]
+
+    cache.clear()
+    assert len(cache) == 0
+    assert cache.cache_info()["size"] == 0
+
+
+def test_cache_propagates_lookup_errors():
+    def lookup(x):
+        raise KeyError(x)
+
+    cache = fn.Cache(lookup)
+    with pytest.raises(KeyError):
+        cache(int)
+    assert len(cache) == 0
+
+    with pytest.raises(TypeError):
+        cache(int, str)
+
+
+def test_caches_are_consistent_under_concurrent_use():
+    import threading
+
+    keys = [object() for _ in range(64)]
+    memo = fn.memoize_one_arg(id, maxsize=32)
+    unbounded = fn.memoize_one_arg(id)
+    cache = fn.Cache(lambda x: None if keys.index(x) % 2 else id(x), negative_ttl=60)
+    errors = []
+
+    def worker(offset):
+        try:
+            for i in range(2000):
+                k = keys[(i * 7 + offset) % len(keys)]
+                assert memo(k) == id(k)
+                assert unbounded(k) == id(k)
+                assert cache(k) == (None if keys.index(k) % 2 else id(k))
+        except BaseException as e:
+            errors.append(e)
+
+    threads = [threading.Thread(target=worker, args=(n,)) for n in range(8)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    assert errors == []
+    assert memo.cache_info()["size"] <= 32
+    assert unbounded.cache_info()["size"] == len(keys)
+    assert len(cache) == len(keys)
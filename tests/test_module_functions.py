@@ -1,4 +1,6 @@
-"""Tests for module-level functions: identity, typeof, apply, first_arg."""
+"""Tests for module-level functions: identity, typeof, apply, first_arg, map_batch, filter_batch, pool_info."""
+import gc
+
 import pytest
 import retracesoftware.functional as fn
 
@@ -76,6 +78,126 @@ class TestFirstArg:
             pass
 
 
+class TestMapBatch:
+    def test_matches_map(self):
+        f = fn.compose(abs, lambda x: x - 10)
+        items = list(range(20))
+
+        assert fn.map_batch(f, items) == list(map(f, items))
+
+    def test_accepts_any_iterable(self):
+        assert fn.map_batch(fn.partial(pow, 2), (1, 2, 3)) == [2, 4, 8]
+        assert fn.map_batch(str, iter([1, 2])) == ["1", "2"]
+        assert fn.map_batch(str, []) == []
+
+    def test_list_mutated_by_callback(self):
+        items = [1, 2, 3]
+
+        def grow(x):
+            items.append(x)
+            return x
+
+        assert fn.map_batch(grow, items) == [1, 2, 3]
+
+    def test_callbacks_never_see_a_partial_result(self):
+        def scan(x):
+            # reading every tracked list would touch an unfilled result slot
+            for obj in gc.get_objects():
+                if type(obj) is list:
+                    list(obj)
+            return x
+
+        assert fn.map_batch(scan, [1, 2]) == [1, 2]
+
+    def test_errors_propagate(self):
+        with pytest.raises(ZeroDivisionError):
+            fn.map_batch(lambda x: 1 / x, [1, 0, 2])
+
+    def test_rejects_bad_arguments(self):
+        with pytest.raises(TypeError):
+            fn.map_batch(42, [1])
+        with pytest.raises(TypeError):
+            fn.map_batch(str)
+
+
+class TestFilterBatch:
+    def test_native_predicates(self):
+        items = [1, "a", True, 2.5, None, 3]
+        pred = fn.and_predicate(fn.isinstanceof(int), fn.not_predicate(fn.isinstanceof(bool)))
+
+        assert fn.filter_batch(pred, items) == [1, 3]
+        assert fn.filter_batch(fn.compile_predicate(pred), items) == [1, 3]
+        assert fn.filter_batch(fn.isinstanceof(str), items) == ["a"]
+
+    def test_python_predicate_uses_truthiness(self):
+        assert fn.filter_batch(lambda x: x % 3, range(7)) == [1, 2, 4, 5]
+
+    def test_errors_propagate(self):
+        def boom(x):
+            raise KeyError(x)
+
+        with pytest.raises(KeyError):
+            fn.filter_batch(boom, [1])
+        with pytest.raises(TypeError):
+            fn.filter_batch(None, [1])
+
+
+class TestPoolInfo:
+    def test_shape(self):
+        info = fn.pool_info()
+
+        assert set(info) == {"deepwrap", "shared"}
+        for entry in info.values():
+            assert entry["size"] <= entry["maxsize"]
+
+    @pytest.mark.skipif(fn.__backend__ == "pure", reason="freelists are native only")
+    def test_deepwrap_reuses_wrappers(self):
+        wrapped = fn.deepwrap(fn.identity, fn.constantly(abs))
+        for _ in range(10):
+            wrapped()
+        before = fn.pool_info()["deepwrap"]
+
+        for _ in range(100):
+            assert wrapped()(-2) == 2
+
+        after = fn.pool_info()["deepwrap"]
+        assert after["hits"] - before["hits"] >= 99
+        assert after["size"] >= 1
+
+    @pytest.mark.skipif(fn.__backend__ == "pure", reason="freelists are native only")
+    def test_shared_pool_reuses_across_types(self):
+        proxy = fn.ThreadLocalProxy()
+        for _ in range(10):
+            fn.ThreadLocalProxy.swap(proxy, abs)
+            fn.partial(abs, -1)
+        before = fn.pool_info()["shared"]
+
+        for _ in range(100):
+            with fn.ThreadLocalProxy.swap(proxy, abs):
+                assert proxy(-1) == 1
+            assert fn.partial(abs, -1)() == 1
+
+        after = fn.pool_info()["shared"]
+        assert after["hits"] - before["hits"] >= 198
+
+    @pytest.mark.skipif(fn.__backend__ == "pure", reason="freelists are native only")
+    def test_subclasses_bypass_pool(self):
+        class Sub(fn.partial):
+            pass
+
+        for _ in range(10):
+            Sub(abs, -1)
+        before = fn.pool_info()["shared"]
+
+        for _ in range(100):
+            s = Sub(abs, -1)
+            s.attr = 1
+            assert s() == 1
+            del s
+
+        assert fn.pool_info()["shared"]["hits"] == before["hits"]
+
+
 class TestModuleDocstrings:
     """Test that all types have proper docstrings."""
     
@@ -154,6 +276,8 @@ class TestModuleImports:
         assert hasattr(fn, 'notinstance_test')
         assert hasattr(fn, 'dispatch')
         assert hasattr(fn, 'firstof')
+        assert hasattr(fn, 'map_batch')
+        assert hasattr(fn, 'filter_batch')
 
 
 class TestEdgeCases:
@@ -1,3 +1,7 @@
+import operator
+import pickle
+
+import pytest
 import retracesoftware.functional as fn
 
 
@@ -28,3 +32,177 @@ def test_partial_required_zero_delays_until_invocation():
     assert lazy() == 8
     assert calls == [4]
 
+
+
+def record(*args, **kwargs):
+    return args, kwargs
+
+
+def test_partial_binds_keyword_arguments():
+    p = fn.partial(record, 1, sep="-", end="!")
+
+    assert p() == ((1,), {"sep": "-", "end": "!"})
+    assert p(2, 3) == ((1, 2, 3), {"sep": "-", "end": "!"})
+
+
+def test_partial_call_keywords_override_bound():
+    p = fn.partial(record, sep="-", end="!")
+
+    assert p(end="?") == ((), {"sep": "-", "end": "?"})
+    assert p(0, flush=True, sep=" ") == ((0,), {"end": "!", "flush": True, "sep": " "})
+    # the bound keywords are unchanged by an override
+    assert p(1) == ((1,), {"sep": "-", "end": "!"})
+
+
+def test_partial_keywords_reach_vectorcall_targets():
+    p = fn.partial(int, base=16)
+
+    assert p("ff") == 255
+    assert p("11", base=2) == 3
+
+    with pytest.raises(TypeError):
+        p("ff", bogus=1)
+
+
+def test_partial_required_zero_passes_bound_keywords():
+    p = fn.partial(record, 1, required=0, key="v")
+
+    assert p("ignored") == ((1,), {"key": "v"})
+
+
+@pytest.mark.skipif(fn.__backend__ == "pure", reason="pure partial is a closure")
+def test_partial_repr_shows_keywords():
+    assert "key=v" in repr(fn.partial(record, 1, key="v"))
+
+
+def test_partial_placeholders_take_leading_call_arguments():
+    _ = fn.Placeholder
+    p = fn.partial(record, _, "x", _, "y")
+
+    assert p(1, 2) == ((1, "x", 2, "y"), {})
+    assert p(1, 2, 3, k=4) == ((1, "x", 2, "y", 3), {"k": 4})
+
+    with pytest.raises(TypeError, match="missing positional arguments"):
+        p(1)
+
+
+def test_partial_placeholder_permutes_arguments():
+    rsub = fn.partial(operator.sub, fn.Placeholder, 10)
+
+    assert rsub(3) == -7
+    assert fn.map_batch(rsub, [10, 20]) == [0, 10]
+
+
+def test_partial_rejects_misplaced_placeholders():
+    _ = fn.Placeholder
+
+    with pytest.raises(TypeError):
+        fn.partial(record, 1, _)
+    with pytest.raises(TypeError):
+        fn.partial(record, key=_)
+    with pytest.raises(TypeError):
+        fn.partial(record, _, 1, required=0)
+    with pytest.raises(TypeError, match="fewer than"):
+        fn.partial(record, _, _, 1, required=1)
+
+
+def test_placeholder_pickles_as_singleton():
+    assert pickle.loads(pickle.dumps(fn.Placeholder)) is fn.Placeholder
+    assert repr(fn.Placeholder) == "Placeholder"
+
+
+def test_nested_partial_matches_nesting():
+    _ = fn.Placeholder
+
+    assert fn.partial(fn.partial(record, 1, k=1), 2, k=2)(3) == ((1, 2, 3), {"k": 2})
+    assert fn.partial(fn.partial(record, _, "x"), "y")(3) == (("y", "x", 3), {})
+    assert fn.partial(fn.partial(record, _, "x", _, "z"), "w")(1) == (("w", "x", 1, "z"), {})
+
+
+@pytest.mark.skipif(fn.__backend__ == "pure", reason="pure partial is a closure")
+def test_nested_partial_collapses():
+    inner = fn.partial(record, 1, k=1)
+    outer = fn.partial(inner, 2, j=2)
+
+    assert repr(outer) == repr(fn.partial(record, 1, 2, k=1, j=2))
+
+    # instance attributes, a subclass or required keep the nesting
+    inner.note = "kept"
+    assert repr(inner) in repr(fn.partial(inner, 2))
+    assert repr(fn.partial(fn.partial(record, 1), 2, required=0)).count("partial(") == 2
+
+
+@pytest.mark.parametrize("required", [1, 2, 3, 4])
+def test_partial_required_fixes_call_arity(required):
+    p = fn.partial(record, "a", required=required, k=1)
+    call_args = tuple(range(required))
+
+    assert p(*call_args) == (("a",) + call_args, {"k": 1})
+    assert p(*call_args, k=2, j=3) == (("a",) + call_args, {"k": 2, "j": 3})
+
+    with pytest.raises(TypeError, match="positional argument"):
+        p(*call_args, "extra")
+    with pytest.raises(TypeError, match="positional argument"):
+        p(*call_args[1:])
+
+
+def test_partial_required_with_many_bound_arguments():
+    p = fn.partial(record, *range(8), required=2)
+
+    assert p("x", "y") == ((*range(8), "x", "y"), {})
+    with pytest.raises(TypeError):
+        p("x")
+
+
+def test_partial_required_counts_placeholder_arguments():
+    p = fn.partial(operator.sub, fn.Placeholder, 1, required=1)
+
+    assert p(5) == 4
+    with pytest.raises(TypeError):
+        p(5, 6)
+
+
+def test_partial_required_must_be_non_negative_int():
+    with pytest.raises(TypeError):
+        fn.partial(record, required=-1)
+    with pytest.raises(TypeError):
+        fn.partial(record, required="1")
+    with pytest.raises(TypeError):
+        fn.partial(record, required=-2**70)
+
+
+def test_partial_required_overflow_is_not_hidden():
+    if fn.__backend__ == "pure":
+        pytest.skip("pure partial takes any int")
+
+    with pytest.raises(OverflowError):
+        fn.partial(record, required=2**70)
+    with pytest.raises(OverflowError):
+        fn.partial(record, required=2**40)
+
+
+def test_partial_single_bound_argument_leaves_caller_arguments_intact():
+    p = fn.partial(record, "a")
+    values = [object(), object()]
+
+    for v in values:
+        assert p(v) == (("a", v), {})
+        assert p(v, k=v) == (("a", v), {"k": v})
+    assert values == [values[0], values[1]]
+
+    with pytest.raises(ZeroDivisionError):
+        fn.partial(operator.truediv, 1)(0)
+
+
+def test_partial_single_bound_argument_in_chains():
+    p = fn.partial(record, "a")
+
+    assert fn.mapargs(p, str)(1) == (("a", "1"), {})
+    assert fn.dropargs(p)(0, 1) == (("a", 1), {})
+    assert fn.partial(record, "a", required=1)(2) == (("a", 2), {})
+
+    class Owner:
+        method = fn.partial(record, "a")
+
+    owner = Owner()
+    assert owner.method(1) == (("a", owner, 1), {})
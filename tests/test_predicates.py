@@ -200,3 +200,190 @@ class TestNotinstanceTest:
         
         assert test("hello") is None
 
+
+
+class TestNestedPredicates:
+    def test_nested_tree_of_native_predicates(self):
+        pred = fn.and_predicate(
+            fn.or_predicate(fn.isinstanceof(int), fn.isinstanceof(str)),
+            fn.not_predicate(fn.isinstanceof(bool)),
+        )
+
+        assert pred(1) is True
+        assert pred("a") is True
+        assert pred(True) is False
+        assert pred(1.5) is False
+
+    def test_python_predicates_use_truthiness(self):
+        pred = fn.or_predicate(fn.isinstanceof(str), lambda x: x)
+
+        assert pred([1]) is True
+        assert pred([]) is False
+        assert fn.not_predicate(lambda x: x)(0) is True
+
+    def test_errors_propagate_through_native_parents(self):
+        class Boom(Exception):
+            pass
+
+        def boom(x):
+            raise Boom()
+
+        pred = fn.not_predicate(fn.and_predicate(fn.isinstanceof(int), boom))
+
+        with pytest.raises(Boom):
+            pred(1)
+        assert pred("a") is True
+
+    def test_truthiness_errors_propagate(self):
+        class Bad:
+            def __bool__(self):
+                raise ValueError("no truth")
+
+        pred = fn.and_predicate(lambda x: Bad())
+
+        with pytest.raises(ValueError):
+            pred(1)
+
+    def test_branching_combinators_take_native_tests(self):
+        is_text = fn.or_predicate(fn.isinstanceof(str), fn.isinstanceof(bytes))
+        label = fn.if_then_else(is_text, lambda x: "text", lambda x: "other")
+
+        assert label("a") == "text"
+        assert label(b"a") == "text"
+        assert label(1) == "other"
+        assert fn.when_predicate(is_text, len)("abc") == 3
+
+
+class TestCompilePredicate:
+    def test_matches_source_tree(self):
+        tree = fn.and_predicate(
+            fn.or_predicate(fn.isinstanceof(int), fn.isinstanceof(str)),
+            fn.not_predicate(fn.isinstanceof(bool)),
+        )
+        compiled = fn.compile_predicate(tree)
+
+        for value in (1, "a", True, 1.5, None, b"x"):
+            assert compiled(value) is tree(value)
+
+    def test_opaque_predicates_are_called_in_order(self):
+        calls = []
+
+        def positive(x):
+            calls.append(x)
+            return x > 0
+
+        compiled = fn.compile_predicate(
+            fn.or_predicate(fn.isinstanceof(str), fn.and_predicate(fn.isinstanceof(int), positive)))
+
+        assert compiled("a") is True
+        assert compiled(1.5) is False
+        assert calls == []
+        assert compiled(3) is True
+        assert compiled(-3) is False
+        assert calls == [3, -3]
+
+    def test_constants_and_empty_combinators(self):
+        assert fn.compile_predicate(fn.and_predicate())(1) is True
+        assert fn.compile_predicate(fn.or_predicate())(1) is False
+        assert fn.compile_predicate(fn.or_predicate(fn.constantly(False), fn.constantly(True)))(1) is True
+
+    def test_type_tests_still_check_arguments(self):
+        compiled = fn.compile_predicate(fn.isinstanceof(int))
+
+        with pytest.raises(TypeError):
+            compiled(1, 2)
+
+    def test_errors_propagate(self):
+        def boom(x):
+            raise KeyError(x)
+
+        compiled = fn.compile_predicate(fn.not_predicate(boom))
+
+        with pytest.raises(KeyError):
+            compiled(1)
+
+    def test_disassemble_lists_instructions(self):
+        compiled = fn.compile_predicate(
+            fn.and_predicate(fn.isinstanceof(int), fn.not_predicate(fn.isinstanceof(bool))))
+
+        text = compiled.disassemble()
+
+        assert isinstance(text, str)
+        assert compiled.source is not None
+        if fn.__backend__ != "pure":
+            assert len(text.splitlines()) == 2
+            assert "ISINSTANCE" in text
+
+    def test_rejects_non_callable(self):
+        with pytest.raises(TypeError):
+            fn.compile_predicate(42)
+
+
+class TestAdaptivePredicates:
+    def test_results_match_fixed_order(self):
+        preds = (fn.isinstanceof(int), lambda x: x > 0, fn.not_predicate(fn.isinstanceof(bool)))
+
+        for combinator in (fn.and_predicate, fn.or_predicate):
+            fixed = combinator(*preds)
+            adaptive = combinator(*preds, adaptive=True)
+
+            for _ in range(3000):
+                for value in (1, -1, True, 0):
+                    assert adaptive(value) is fixed(value)
+
+    def test_decisive_predicate_moves_first(self):
+        calls = []
+
+        def always(x):
+            calls.append(x)
+            return True
+
+        selective = fn.isinstanceof(str)
+        pred = fn.and_predicate(always, selective, adaptive=True)
+
+        assert pred.order == (always, selective)
+
+        for i in range(5000):
+            assert pred(i) is False
+        pred.reorder()
+
+        if fn.__backend__ != "pure":
+            assert pred.order == (selective, always)
+            calls.clear()
+            assert pred(1) is False
+            assert calls == []
+
+    def test_adaptive_info(self):
+        assert fn.or_predicate(bool).adaptive_info() is None
+
+        pred = fn.or_predicate(fn.isinstanceof(str), bool, adaptive=True)
+        for i in range(100):
+            pred(i)
+
+        info = pred.adaptive_info()
+        if fn.__backend__ != "pure":
+            assert info["calls"] == 100
+            assert [p["predicate"] for p in info["predicates"]] == list(pred.order)
+            assert set(info["predicates"][0]) == {"predicate", "evals", "decided", "cycles"}
+
+    def test_compiled_keeps_adaptive_node(self):
+        inner = fn.and_predicate(fn.isinstanceof(int), bool, adaptive=True)
+        compiled = fn.compile_predicate(fn.or_predicate(fn.isinstanceof(str), inner))
+
+        for value in ("a", 1, 0, None):
+            assert compiled(value) is fn.or_predicate(fn.isinstanceof(str), inner)(value)
+
+    def test_errors_propagate(self):
+        def boom(x):
+            raise KeyError(x)
+
+        pred = fn.and_predicate(bool, boom, adaptive=True)
+
+        for _ in range(100):
+            with pytest.raises(KeyError):
+                pred(1)
+
+    def test_too_many_predicates(self):
+        with pytest.raises(ValueError):
+            fn.and_predicate(*([bool] * 17), adaptive=True)
+        fn.and_predicate(*([bool] * 17))
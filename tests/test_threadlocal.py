@@ -0,0 +1,135 @@
+import gc
+import threading
+import weakref
+
+import pytest
+import retracesoftware.functional as fn
+
+
+def test_threadlocal_proxy_forwards_to_current_thread_target():
+    proxy = fn.ThreadLocalProxy()
+
+    assert fn.ThreadLocalProxy.set(proxy, lambda x: x + 1) is None
+    assert proxy(1) == 2
+
+    seen = []
+
+    def other():
+        with pytest.raises(fn.ThreadLocalError):
+            proxy(1)
+        fn.ThreadLocalProxy.set(proxy, lambda x: x * 10)
+        seen.append(proxy(2))
+
+    t = threading.Thread(target=other)
+    t.start()
+    t.join()
+
+    assert seen == [20]
+    assert proxy(1) == 2
+
+
+def test_threadlocal_proxy_unset_and_custom_error():
+    proxy = fn.ThreadLocalProxy(error=LookupError)
+
+    with pytest.raises(LookupError):
+        proxy()
+
+    target = lambda: "ok"
+    fn.ThreadLocalProxy.set(proxy, target)
+    assert fn.ThreadLocalProxy.get(proxy) is target
+    assert fn.ThreadLocalProxy.set(proxy, None) is target
+    assert fn.ThreadLocalProxy.get(proxy) is None
+
+    with pytest.raises(TypeError):
+        fn.ThreadLocalProxy(error=42)
+
+
+def test_threadlocal_proxy_forwards_attributes_and_iteration():
+    class Target:
+        name = "t"
+
+    proxy = fn.ThreadLocalProxy()
+    target = Target()
+    fn.ThreadLocalProxy.set(proxy, target)
+
+    assert proxy.name == "t"
+    proxy.value = 3
+    assert target.value == 3
+
+    fn.ThreadLocalProxy.set(proxy, [1, 2, 3])
+    assert list(proxy) == [1, 2, 3]
+
+
+def test_threadlocal_proxy_swap_restores_previous_target():
+    proxy = fn.ThreadLocalProxy()
+    outer = lambda: "outer"
+    inner = lambda: "inner"
+
+    fn.ThreadLocalProxy.set(proxy, outer)
+
+    with fn.ThreadLocalProxy.swap(proxy, inner) as bound:
+        assert bound is inner
+        assert proxy() == "inner"
+        with fn.ThreadLocalProxy.swap(proxy, outer):
+            assert proxy() == "outer"
+        assert proxy() == "inner"
+
+    assert proxy() == "outer"
+
+    with pytest.raises(KeyError):
+        with fn.ThreadLocalProxy.swap(proxy, inner):
+            raise KeyError("boom")
+    assert proxy() == "outer"
+
+
+def test_threadlocal_proxy_swap_from_unset():
+    proxy = fn.ThreadLocalProxy()
+
+    with fn.ThreadLocalProxy.swap(proxy, lambda: 1):
+        assert proxy() == 1
+
+    assert fn.ThreadLocalProxy.get(proxy) is None
+
+
+def test_threadlocal_proxy_target_may_rebind_itself():
+    proxy = fn.ThreadLocalProxy()
+
+    class Target:
+        def __call__(self):
+            fn.ThreadLocalProxy.set(proxy, None)
+            return self.value
+
+    target = Target()
+    target.value = "still alive"
+    fn.ThreadLocalProxy.set(proxy, target)
+    del target
+
+    assert proxy() == "still alive"
+    assert fn.ThreadLocalProxy.get(proxy) is None
+
+
+def test_threadlocal_proxy_releases_target_when_thread_exits():
+    proxy = fn.ThreadLocalProxy()
+
+    class Target:
+        def __call__(self):
+            return 1
+
+    refs = []
+
+    def worker():
+        target = Target()
+        refs.append(weakref.ref(target))
+        fn.ThreadLocalProxy.set(proxy, target)
+        assert proxy() == 1
+
+    for _ in range(4):
+        t = threading.Thread(target=worker)
+        t.start()
+        t.join()
+
+    gc.collect()
+    assert [ref() for ref in refs] == [None] * 4
+
+    fn.ThreadLocalProxy.set(proxy, len)
+    assert proxy("abc") == 3
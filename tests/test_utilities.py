@@ -1,4 +1,9 @@
-"""Tests for utility functions: always, constantly, cond, first, firstof, lazy, anyargs, selfapply."""
+"""Tests for utility functions: always, constantly, cond, first, firstof, lazy, delay, anyargs, selfapply."""
+import gc
+import threading
+import time
+import weakref
+
 import pytest
 import retracesoftware.functional as fn
 
@@ -186,6 +191,115 @@ class TestLazy:
         assert lazy("ignored", "args") == 12
 
 
+class TestDelay:
+    def test_evaluates_once(self):
+        calls = []
+
+        def compute(x, y):
+            calls.append((x, y))
+            return [x + y]
+
+        value = fn.delay(compute, 1, 2)
+        assert calls == []
+
+        first = value()
+        assert first == [3]
+        assert value("ignored", key=1) is first
+        assert calls == [(1, 2)]
+
+    def test_lazy_once(self):
+        calls = []
+        value = fn.lazy(lambda: calls.append(1) or len(calls), once=True)
+
+        assert value() == value() == 1
+        assert fn.lazy(lambda: calls.append(1) or len(calls))() == 2
+
+    def test_caches_exception(self):
+        calls = []
+
+        def fail():
+            calls.append(1)
+            raise KeyError("missing")
+
+        value = fn.delay(fail)
+        for _ in range(3):
+            with pytest.raises(KeyError, match="missing"):
+                value()
+        assert calls == [1]
+
+    def test_cached_exception_traceback_does_not_grow(self):
+        def fail():
+            raise KeyError("missing")
+
+        def depth(tb):
+            n = 0
+            while tb:
+                n, tb = n + 1, tb.tb_next
+            return n
+
+        value = fn.delay(fail)
+        depths = []
+        for _ in range(5):
+            try:
+                value()
+            except KeyError as e:
+                depths.append(depth(e.__traceback__))
+        assert len(set(depths)) == 1
+
+    def test_releases_arguments(self):
+        class Arg:
+            pass
+
+        arg = Arg()
+        ref = weakref.ref(arg)
+        value = fn.delay(lambda a: 42, arg)
+        del arg
+
+        assert ref() is not None
+        assert value() == 42
+        gc.collect()
+        assert ref() is None
+        assert value() == 42
+
+    def test_reentry_raises(self):
+        def compute():
+            return value()
+
+        value = fn.delay(compute)
+        with pytest.raises(RuntimeError):
+            value()
+
+    def test_concurrent_first_calls_evaluate_once(self):
+        calls = []
+        n = 8
+        barrier = threading.Barrier(n)
+
+        def compute():
+            calls.append(1)
+            time.sleep(0.05)
+            return object()
+
+        value = fn.delay(compute)
+        results = [None] * n
+
+        def worker(i):
+            barrier.wait()
+            results[i] = value()
+
+        threads = [threading.Thread(target=worker, args=(i,)) for i in range(n)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        assert len(calls) == 1
+        assert all(r is results[0] for r in results)
+
+    def test_requires_callable(self):
+        with pytest.raises(TypeError):
+            fn.delay(42)
+
+
 class TestAnyArgs:
     def test_calls_function_with_no_args(self):
         counter = [0]